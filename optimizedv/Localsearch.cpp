@@ -4,10 +4,14 @@
 #include<fstream>
 #include<algorithm>
 #include<unordered_set>
+#include<climits>
+#include<cstring>
 
 // Memory management includes
-#include "src/memory/memorytracker.h"
-#include "src/memory/memorypool.h"
+#include "memory/memorytracker.h"
+#include "memory/memorypool.h"
+
+#include "localsearch.h"
 
 using namespace std;
 using namespace chrono;
@@ -17,18 +21,219 @@ namespace {
     MemoryPool hillClimbPool(sizeof(vector<int>), 1000);
 }
 
+// Occupancy tables for min-conflicts: queens per column, per diagonal
+// (row - col + n - 1) and per anti-diagonal (row + col). Next to each count
+// we keep the XOR of the rows on that line, so when a line is down to a
+// single queen we know its row without scanning the board.
+struct ConflictTables {
+    int n;
+    vector<int> colCount, diagCount, antiCount;
+    vector<int> colRows, diagRows, antiRows;
+    // Rows whose queen shares a line with another queen; position[row] is
+    // the row's index in `conflicted`, or -1, for O(1) insert and erase
+    vector<int> conflicted;
+    vector<int> position;
+    
+    ConflictTables(int size)
+        : n(size), colCount(size), diagCount(2 * size - 1), antiCount(2 * size - 1),
+          colRows(size), diagRows(2 * size - 1), antiRows(2 * size - 1), position(size, -1) {}
+};
+
+// Number of other queens attacking (row, col); the queen of `row` itself
+// must not be on that square
+inline int squareConflicts(const ConflictTables& t, int row, int col) {
+    return t.colCount[col] + t.diagCount[row - col + t.n - 1] + t.antiCount[row + col];
+}
+
+// Number of queens attacking the queen placed in `row`
 template<typename Allocator>
-int numOfConflicts(const vector<int, Allocator>& board, int row, int col) {
-    int conflicts = 0;
-    for (int i = 0; i < board.size(); ++i) {
-        if (i == row) continue;
-        if (board[i] == col || abs(board[i] - col) == abs(i - row))
-            conflicts++;
+inline int queenConflicts(const ConflictTables& t, const vector<int, Allocator>& board, int row) {
+    return squareConflicts(t, row, board[row]) - 3;
+}
+
+// Bring `row`'s membership in the conflicted set up to date
+template<typename Allocator>
+void refreshRow(ConflictTables& t, const vector<int, Allocator>& board, int row) {
+    bool conflicted = queenConflicts(t, board, row) > 0;
+    if (conflicted && t.position[row] == -1) {
+        t.position[row] = t.conflicted.size();
+        t.conflicted.push_back(row);
+    } else if (!conflicted && t.position[row] != -1) {
+        int last = t.conflicted.back();
+        t.conflicted[t.position[row]] = last;
+        t.position[last] = t.position[row];
+        t.conflicted.pop_back();
+        t.position[row] = -1;
     }
-    return conflicts;
 }
 
-bool hillClimb(vector<int, MemoryPoolAllocator<int>>& board, int max_steps) {
+// Remove `row` from a line; returns the row of the queen left alone on it, or -1
+inline int leaveLine(int& count, int& rows, int row) {
+    --count;
+    rows ^= row;
+    return count == 1 ? rows : -1;
+}
+
+// Add `row` to a line; returns the row of the queen that was alone on it, or -1
+inline int joinLine(int& count, int& rows, int row) {
+    int alone = count == 1 ? rows : -1;
+    ++count;
+    rows ^= row;
+    return alone;
+}
+
+// Rebuild every table from scratch for the current board, O(n)
+template<typename Allocator>
+void initTables(ConflictTables& t, const vector<int, Allocator>& board) {
+    int n = t.n;
+    fill(t.colCount.begin(), t.colCount.end(), 0);
+    fill(t.diagCount.begin(), t.diagCount.end(), 0);
+    fill(t.antiCount.begin(), t.antiCount.end(), 0);
+    fill(t.colRows.begin(), t.colRows.end(), 0);
+    fill(t.diagRows.begin(), t.diagRows.end(), 0);
+    fill(t.antiRows.begin(), t.antiRows.end(), 0);
+    fill(t.position.begin(), t.position.end(), -1);
+    t.conflicted.clear();
+    
+    for (int row = 0; row < n; ++row) {
+        int col = board[row];
+        joinLine(t.colCount[col], t.colRows[col], row);
+        joinLine(t.diagCount[row - col + n - 1], t.diagRows[row - col + n - 1], row);
+        joinLine(t.antiCount[row + col], t.antiRows[row + col], row);
+    }
+    for (int row = 0; row < n; ++row)
+        refreshRow(t, board, row);
+}
+
+// Move the queen of `row` to `col`, updating counters and the conflicted
+// set in O(1): only queens sharing one of the six touched lines can change
+template<typename Allocator>
+void moveQueen(ConflictTables& t, vector<int, Allocator>& board, int row, int col) {
+    int n = t.n;
+    int old = board[row];
+    int touched[6];
+    
+    touched[0] = leaveLine(t.colCount[old], t.colRows[old], row);
+    touched[1] = leaveLine(t.diagCount[row - old + n - 1], t.diagRows[row - old + n - 1], row);
+    touched[2] = leaveLine(t.antiCount[row + old], t.antiRows[row + old], row);
+    board[row] = col;
+    touched[3] = joinLine(t.colCount[col], t.colRows[col], row);
+    touched[4] = joinLine(t.diagCount[row - col + n - 1], t.diagRows[row - col + n - 1], row);
+    touched[5] = joinLine(t.antiCount[row + col], t.antiRows[row + col], row);
+    
+    for (int other : touched) {
+        if (other != -1)
+            refreshRow(t, board, other);
+    }
+    refreshRow(t, board, row);
+}
+
+const char* initName(InitStrategy init) {
+    switch (init) {
+        case InitStrategy::Random: return "random";
+        case InitStrategy::Permutation: return "permutation";
+        case InitStrategy::Greedy: return "greedy";
+        case InitStrategy::SosicGu: return "sosic-gu";
+    }
+    return "unknown";
+}
+
+bool parseInit(const char* name, InitStrategy& init) {
+    for (InitStrategy candidate : { InitStrategy::Random, InitStrategy::Permutation,
+                                    InitStrategy::Greedy, InitStrategy::SosicGu }) {
+        if (strcmp(name, initName(candidate)) == 0) {
+            init = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Rows placed at random at the end of the Sosic-Gu init; past that point
+// diagonal-safe columns become too rare to be worth searching for
+const int SosicGuFreeRows = 100;
+
+template<typename Allocator>
+void shuffleRange(vector<int, Allocator>& board, int from, int to) {
+    for (int i = to - 1; i > from; --i)
+        swap(board[i], board[from + rand() % (i - from + 1)]);
+}
+
+// Fill `board` with an initial assignment; `t` is used as scratch and must
+// be rebuilt with initTables() afterwards
+template<typename Allocator>
+void initBoard(InitStrategy init, ConflictTables& t, vector<int, Allocator>& board) {
+    int n = t.n;
+    if (init == InitStrategy::Random) {
+        for (int i = 0; i < n; ++i)
+            board[i] = rand() % n;
+        return;
+    }
+    
+    if (init == InitStrategy::Greedy) {
+        fill(t.colCount.begin(), t.colCount.end(), 0);
+        fill(t.diagCount.begin(), t.diagCount.end(), 0);
+        fill(t.antiCount.begin(), t.antiCount.end(), 0);
+        for (int row = 0; row < n; ++row) {
+            int best_col = 0;
+            int min_conflict = INT_MAX;
+            int ties = 0;
+            for (int col = 0; col < n; ++col) {
+                int conflicts = squareConflicts(t, row, col);
+                if (conflicts < min_conflict) {
+                    min_conflict = conflicts;
+                    best_col = col;
+                    ties = 1;
+                } else if (conflicts == min_conflict && rand() % ++ties == 0) {
+                    best_col = col;
+                }
+            }
+            board[row] = best_col;
+            t.colCount[best_col]++;
+            t.diagCount[row - best_col + n - 1]++;
+            t.antiCount[row + best_col]++;
+        }
+        return;
+    }
+    
+    for (int i = 0; i < n; ++i)
+        board[i] = i;
+    if (init == InitStrategy::Permutation) {
+        shuffleRange(board, 0, n);
+        return;
+    }
+    
+    // Sosic-Gu: walk the permutation, swapping into row i a later column
+    // that no earlier queen attacks diagonally, then shuffle the tail
+    fill(t.diagCount.begin(), t.diagCount.end(), 0);
+    fill(t.antiCount.begin(), t.antiCount.end(), 0);
+    int safe_rows = max(0, n - SosicGuFreeRows);
+    for (int i = 0; i < safe_rows; ++i) {
+        int remaining = n - i;
+        for (int tries = 0; tries < 2 * remaining; ++tries) {
+            int j = i + rand() % remaining;
+            if (t.diagCount[i - board[j] + n - 1] == 0 && t.antiCount[i + board[j]] == 0) {
+                swap(board[i], board[j]);
+                break;
+            }
+        }
+        t.diagCount[i - board[i] + n - 1]++;
+        t.antiCount[i + board[i]]++;
+    }
+    shuffleRange(board, safe_rows, n);
+}
+
+// Pick a random conflicted row, resampling a few times to avoid rows moved
+// within the last `tenure` steps
+int pickRow(const ConflictTables& t, const vector<int>& lastMoved, int step, int tenure) {
+    int row = t.conflicted[rand() % t.conflicted.size()];
+    for (int tries = 0; tries < 8 && step - lastMoved[row] < tenure; ++tries)
+        row = t.conflicted[rand() % t.conflicted.size()];
+    return row;
+}
+
+ClimbResult hillClimb(vector<int, MemoryPoolAllocator<int>>& board, int max_steps,
+                      const RestartPolicy& policy, InitStrategy init) {
     // Enable memory tracking for this run
     #ifdef TRACK_MEMORY
     MemoryTracker::reset();
@@ -36,90 +241,176 @@ bool hillClimb(vector<int, MemoryPoolAllocator<int>>& board, int max_steps) {
     #endif
     
     int n = board.size();
-    srand(time(nullptr));
-    for (int i = 0; i < n; ++i)
-        board[i] = rand() % n;
+    ClimbResult result;
+    
+    // Allocated once; a restart only refills the board and the tables
+    ConflictTables tables(n);
+    vector<int> lastMoved(n);
+    
+    for (;;) {
+        #ifdef TRACK_MEMORY
+        MemoryTracker::markPhase("hillclimb N=" + to_string(n) + " init " + to_string(result.stats.restarts));
+        #endif
+        auto init_start = high_resolution_clock::now();
+        initBoard(init, tables, board);
+        initTables(tables, board);
+        result.init_seconds += duration<double>(high_resolution_clock::now() - init_start).count();
+        #ifdef TRACK_MEMORY
+        MemoryTracker::markPhase("hillclimb N=" + to_string(n) + " climb");
+        #endif
+        fill(lastMoved.begin(), lastMoved.end(), -policy.tabu_tenure);
+        int sideways_left = policy.sideways_budget;
         
-    for (int step = 0; step < max_steps; ++step) {
-        vector<int, MemoryPoolAllocator<int>> conflicted_rows(hillClimbPool);
-        for (int row = 0; row < n; ++row) {
-            if (numOfConflicts(board, row, board[row]) > 0)
-                conflicted_rows.push_back(row);
-        }
-        if (conflicted_rows.empty()) {
-            #ifdef TRACK_MEMORY
-            MemoryTracker::generateReport("hillclimb_success_memory.txt");
-            #endif
-            return true;
-        }
-        int row = conflicted_rows[rand() % conflicted_rows.size()];
-        int best_col = board[row];
-        int min_conflict = numOfConflicts(board, row, best_col);
-        for (int col = 0; col < n; ++col) {
-            int conflicts = numOfConflicts(board, row, col);
-            if (conflicts < min_conflict) {
-                min_conflict = conflicts;
-                best_col = col;
+        // One check more than moves, so a board solved by the last move counts
+        for (int step = 0; step <= max_steps; ++step) {
+            if (tables.conflicted.empty()) {
+                #ifdef TRACK_MEMORY
+                MemoryTracker::markPhase("hillclimb N=" + to_string(n) + " solved");
+                MemoryTracker::generateReport("hillclimb_success_memory.txt");
+                #endif
+                result.solved = true;
+                return result;
             }
+            if (step == max_steps)
+                break;
+            int row = pickRow(tables, lastMoved, step, policy.tabu_tenure);
+            int current = queenConflicts(tables, board, row);
+            STAT_ADD(result.stats, nodes, n - 1);
+            
+            // Least-conflicted other column, ties broken uniformly at random
+            int best_col = -1;
+            int min_conflict = INT_MAX;
+            int ties = 0;
+            for (int col = 0; col < n; ++col) {
+                if (col == board[row]) continue;
+                int conflicts = squareConflicts(tables, row, col);
+                if (conflicts < min_conflict) {
+                    min_conflict = conflicts;
+                    best_col = col;
+                    ties = 1;
+                } else if (conflicts == min_conflict && rand() % ++ties == 0) {
+                    best_col = col;
+                }
+            }
+            
+            if (min_conflict < current) {
+                sideways_left = policy.sideways_budget;
+            } else if (min_conflict == current && sideways_left > 0) {
+                --sideways_left;
+                STAT_ADD(result.stats, sideways, 1);
+            } else {
+                break; // local minimum or plateau with no budget left
+            }
+            moveQueen(tables, board, row, best_col);
+            lastMoved[row] = step;
+            result.stats.moves++;
         }
-        if (best_col == board[row]) {
-            #ifdef TRACK_MEMORY
-            MemoryTracker::generateReport("hillclimb_failed_memory.txt");
-            #endif
-            return false;
-        }
-        board[row] = best_col;
         
-        // Periodic memory reporting (every 1000 steps)
-        #ifdef TRACK_MEMORY
-        if (step % 1000 == 0) {
-            cout << "Step " << step << ": Memory usage = " 
-                 << MemoryTracker::getCurrentUsage() << " bytes\n";
-        }
-        #endif
+        if (result.stats.restarts == static_cast<uint64_t>(policy.max_restarts))
+            break;
+        result.stats.restarts++;
     }
     
     #ifdef TRACK_MEMORY
     MemoryTracker::generateReport("hillclimb_failed_memory.txt");
     #endif
-    return false;
+    return result;
 }
 
-double runHillClimbing(int n, int max_steps = 1000000) {
+double runHillClimbing(int n, const RestartPolicy& policy, InitStrategy init, ClimbResult& result,
+                       int max_steps) {
     vector<int, MemoryPoolAllocator<int>> board(hillClimbPool);
     board.resize(n);
     
     auto start = high_resolution_clock::now();
-    bool success = hillClimb(board, max_steps);
+    result = hillClimb(board, max_steps, policy, init);
     auto end = high_resolution_clock::now();
     
-    if (success) {
-        cout << "Hill climbing SUCCESS for N = " << n << endl;
+    if (result.solved) {
+        cout << "Hill climbing SUCCESS for N = " << n;
     } else {
-        cout << "Hill climbing FAILED for N = " << n << endl;
+        cout << "Hill climbing FAILED for N = " << n;
     }
+    cout << " (" << result.stats.restarts << " restarts, " << result.stats.moves << " steps)" << endl;
     
     return duration<double>(end - start).count();
 }
 
-int main() {
+#ifndef NQUEENS_UNIFIED
+int main(int argc, char** argv) {
     srand(time(nullptr));
     
+    RestartPolicy policy;
+    InitStrategy init = InitStrategy::SosicGu;
+    int trials = 5;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--trials") == 0 && i + 1 < argc) {
+            trials = max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--max-restarts") == 0 && i + 1 < argc) {
+            policy.max_restarts = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sideways") == 0 && i + 1 < argc) {
+            policy.sideways_budget = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--tabu") == 0 && i + 1 < argc) {
+            policy.tabu_tenure = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--init") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            if (!parseInit(name, init)) {
+                cerr << "Unknown init strategy: " << name << "\n";
+                return 1;
+            }
+        } else {
+            cerr << "Usage: " << argv[0]
+                 << " [--trials T] [--max-restarts R] [--sideways S] [--tabu K]"
+                 << " [--init random|permutation|greedy|sosic-gu]\n";
+            return 1;
+        }
+    }
+    
     #ifdef TRACK_MEMORY
     cout << "Memory tracking ENABLED for hill climbing\n";
     MemoryTracker::enable();
+    MemoryTracker::startTimeline();
     #endif
     
     ofstream file("nqueens_hillclimbing_results.csv");
-    vector<int> TstValues = { 4, 8, 16, 32, 64, 128, 256, 512, 1024 };
-    file << "N,Time(seconds)\n";
-    cout << "Pure Hill Climbing Results:\n";
+    vector<int> TstValues = { 4, 8, 16, 32, 64, 128, 256, 512, 1024, 16384, 131072, 1048576 };
+    // Time(seconds) is the mean time-to-solution of the successful trials,
+    // InitTime(seconds) and Steps the per-trial means of the two phases
+    file << "N,Time(seconds),InitTime(seconds),SuccessRate,Restarts,Steps\n";
+    cout << "Hill Climbing Results (" << trials << " trials per N, " << initName(init) << " init, "
+         << policy.max_restarts << " restarts, " << policy.sideways_budget
+         << " sideways moves, tabu tenure " << policy.tabu_tenure << "):\n";
     
     for (int n : TstValues) {
         cout << "Running for N = " << n << "...\n";
-        double time_taken = runHillClimbing(n);
-        file << n << "," << time_taken << "\n";
-        cout << "Time = " << time_taken << " seconds\n";
+        int successes = 0;
+        double solve_time = 0.0;
+        double init_time = 0.0;
+        long long restarts = 0;
+        long long steps = 0;
+        for (int trial = 0; trial < trials; ++trial) {
+            ClimbResult result;
+            double time_taken = runHillClimbing(n, policy, init, result);
+            init_time += result.init_seconds;
+            restarts += result.stats.restarts;
+            steps += result.stats.moves;
+            if (result.solved) {
+                successes++;
+                solve_time += time_taken;
+            }
+        }
+        
+        double success_rate = static_cast<double>(successes) / trials;
+        file << n << ",";
+        if (successes > 0)
+            file << solve_time / successes;
+        file << "," << init_time / trials << "," << success_rate
+             << "," << static_cast<double>(restarts) / trials
+             << "," << static_cast<double>(steps) / trials << "\n";
+        cout << "Success rate = " << success_rate * 100 << "%";
+        if (successes > 0)
+            cout << ", mean time to solution = " << solve_time / successes << " seconds";
+        cout << "\n";
         
         #ifdef TRACK_MEMORY
         // Generate memory report for each N
@@ -132,9 +423,13 @@ int main() {
     file.close();
     
     #ifdef TRACK_MEMORY
+    MemoryTracker::stopTimeline();
+    MemoryTracker::exportTimelineCSV("hillclimb_timeline.csv");
+    MemoryTracker::exportChromeTrace("hillclimb_timeline.json");
     // Final leak check
     MemoryTracker::generateLeakReport("hillclimb_final_leaks.txt");
     #endif
     
     return 0;
-}
\ No newline at end of file
+}
+#endif // NQUEENS_UNIFIED
\ No newline at end of file
@@ -1,15 +1,20 @@
+import sys
 import matplotlib.pyplot
 import pandas
-#insert your path here 
-DFS_q = pandas.read_csv()
-LOCAL_q = pandas.read_csv()
-CSP_q = pandas.read_csv()
-matplotlib.pyplot.plot(DFS_q["N"], DFS_q["Time(seconds)"], marker='o', label="Blind DFS (C++)",color = 'purple')
+# summary CSV written by `nqueens --out`; pass another path as the first argument
+results = pandas.read_csv(sys.argv[1] if len(sys.argv) > 1 else "nqueens_results.csv")
+DFS_q = results[results["Solver"] == "dfs"]
+LOCAL_q = results[results["Solver"] == "minconflicts"]
+CSP_q = results[results["Solver"] == "csp"]
+matplotlib.pyplot.plot(DFS_q["N"], DFS_q["Time(seconds)"], marker='o', label="Bitboard DFS (C++)",color = 'purple')
 matplotlib.pyplot.plot(LOCAL_q["N"], LOCAL_q["Time(seconds)"], marker='o', label="Local search (C++)",color = 'blue')
-matplotlib.pyplot.plot(CSP_q["N"], CSP_q["Time(seconds)"], marker='x', label="CSP with MRV+LCV+FC (C++)",color = 'green')
+matplotlib.pyplot.plot(CSP_q["N"], CSP_q["Time(seconds)"], marker='x', label="CSP with MRV+centre order+AC-3 (C++)",color = 'green')
+# Time(seconds) is the median run; shade from the fastest run to p90
+for q, color in ((DFS_q, 'purple'), (LOCAL_q, 'blue'), (CSP_q, 'green')):
+    matplotlib.pyplot.fill_between(q["N"], q["Min"], q["P90"], color = color, alpha = 0.2)
 # matplotlib.pyplot.xlabel("N (Board Size)")
 # matplotlib.pyplot.ylabel("Time (seconds)")
-# matplotlib.pyplot.title("Performance of Blind DFS vs CSP (N-Queens, C++)")
+# matplotlib.pyplot.title("Performance of Bitboard DFS vs CSP (N-Queens, C++)")
 # matplotlib.pyplot.legend()
 # matplotlib.pyplot.grid(True)
 # matplotlib.pyplot.tight_layout()
@@ -19,8 +24,8 @@ matplotlib.pyplot.plot(CSP_q["N"], CSP_q["Time(seconds)"], marker='x', label="CS
 # zoomed in 
 
 matplotlib.pyplot.xlabel("N (Board Size)")
-matplotlib.pyplot.ylabel("Time (seconds)")
-matplotlib.pyplot.title("Performance of Blind DFS vs CSP (N-Queens, C++)")
+matplotlib.pyplot.ylabel("Median time (seconds)")
+matplotlib.pyplot.title("Performance of Bitboard DFS vs CSP (N-Queens, C++)")
 matplotlib.pyplot.yscale('log')
 matplotlib.pyplot.legend()
 matplotlib.pyplot.grid(True, which = "both", linestyle='--', linewidth=0.5)
@@ -0,0 +1,40 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty())
+        return 0.0;
+    double rank = p / 100.0 * (sorted.size() - 1);
+    size_t lower = static_cast<size_t>(rank);
+    size_t upper = std::min(lower + 1, sorted.size() - 1);
+    double fraction = rank - lower;
+    return sorted[lower] + (sorted[upper] - sorted[lower]) * fraction;
+}
+
+TimingSummary summarize(std::vector<double> samples) {
+    TimingSummary summary;
+    summary.runs = static_cast<int>(samples.size());
+    if (samples.empty())
+        return summary;
+    
+    std::sort(samples.begin(), samples.end());
+    summary.min = samples.front();
+    summary.median = percentile(samples, 50.0);
+    summary.p90 = percentile(samples, 90.0);
+    summary.p99 = percentile(samples, 99.0);
+    
+    double sum = 0.0;
+    for (double s : samples)
+        sum += s;
+    summary.mean = sum / samples.size();
+    
+    if (samples.size() > 1) {
+        double squares = 0.0;
+        for (double s : samples)
+            squares += (s - summary.mean) * (s - summary.mean);
+        summary.stddev = std::sqrt(squares / (samples.size() - 1));
+    }
+    return summary;
+}
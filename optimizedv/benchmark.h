@@ -0,0 +1,23 @@
+#ifndef NQUEENS_BENCHMARK_H
+#define NQUEENS_BENCHMARK_H
+
+#include <vector>
+
+// Distribution of the timed repetitions of one (solver, N) pair, in seconds
+struct TimingSummary {
+    int runs = 0;
+    double min = 0.0;
+    double median = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double mean = 0.0;
+    double stddev = 0.0;  // sample standard deviation (0 for a single run)
+};
+
+// p-th percentile (0..100) of ascending `sorted`, interpolating linearly
+// between the two nearest ranks
+double percentile(const std::vector<double>& sorted, double p);
+
+TimingSummary summarize(std::vector<double> samples);
+
+#endif // NQUEENS_BENCHMARK_H
@@ -3,12 +3,17 @@
 #include <chrono>
 #include <fstream>
 #include <algorithm>
-#include <unordered_set>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
 
 // Memory management includes
-#include "src/memory/memorytracker.h"
-#include "src/memory/memorypool.h"
-#include "src/memory/arenaallocator.h"
+#include "memory/memorytracker.h"
+#include "memory/memorypool.h"
+#include "memory/arenaallocator.h"
+
+#include "csp.h"
+#include "csp_internal.h"
 
 using namespace std;
 using namespace chrono;
@@ -16,50 +21,182 @@ using namespace chrono;
 // Global memory pools for CSP
 namespace {
     MemoryPool cspPool(sizeof(vector<int>), 1000);
-    ArenaAllocator cspArena(8192); // 8KB for CSP
+    ArenaAllocator cspArena(8192); // 8KB for CSP scratch, always on the heap
 }
 
-struct CSPState {
-    int n;
-    vector<int, MemoryPoolAllocator<int>> assignment;
-    vector<unordered_set<int>> domains;
-    
-    CSPState(int size) : n(size), assignment(cspPool), domains(size) {
-        assignment.resize(size, -1);
+// Domain bitsets of the board being solved, backed per cspArenaOptions
+ArenaAllocator cspBoardArena(65536);
+
+BitDomains::BitDomains(int size)
+    : n(size), words((size + 63) / 64), bits(size * words, 0, ArenaAllocatorWrapper<uint64_t>(cspBoardArena)),
+      sizes(size, 0) {}
+
+CSPState::CSPState(int size, bool shuffled)
+    : n(size), assignment(cspPool), domains(size), mrv(size),
+      colSupport(size, size), diagSupport(2 * size - 1), antiSupport(2 * size - 1) {
+    assignment.resize(size, -1);
+    domains.fill_all();
+    vector<int> order(size);
+    for (int i = 0; i < size; ++i)
+        order[i] = i;
+    if (shuffled) {
+        for (int i = size - 1; i > 0; --i)
+            swap(order[i], order[rand() % (i + 1)]);
+    } else {
+        sort(order.begin(), order.end(), [size](int a, int b) {
+            int da = centre_distance(size, a), db = centre_distance(size, b);
+            return da != db ? da > db : a < b;
+        });
+    }
+    for (int row : order)
+        mrv.insert(row, size);
+    for (int d = 0; d < 2 * size - 1; ++d) {
+        diagSupport[d] = size - abs(d - (size - 1));
+        antiSupport[d] = size - abs(d - (size - 1));
     }
-};
+    trail.reserve(size);
+    stack.reserve(size);
+    values.reserve(size);
+}
 
-bool is_safe(const vector<int>& assignment, int row, int col) {
-    for (int r = 0; r < row; ++r) {
-        int c = assignment[r];
-        if (c == col || abs(c - col) == abs(r - row))
-            return false;
-    } 
+// Remove col from row's domain, recording it on the trail
+bool prune(CSPState& state, int row, int col) {
+    if (!state.domains.remove(row, col))
+        return false;
+    add_support(state, row, col, -1);
+    STAT_ADD(state.stats, pruned, 1);
+    int size = state.domains.size(row);
+    state.mrv.move(row, size + 1, size);
+    state.trail.emplace_back(row, col);
     return true;
 }
 
-// Level 2 forward check with arena allocator
+// Remove every value of `mask` from word i of row's domain, recording each
+// on the trail; returns how many were removed
+int prune_word(CSPState& state, int row, int i, uint64_t mask) {
+    int old_size = state.domains.size(row);
+    int count = state.domains.remove_mask(row, i, mask);
+    for (uint64_t bits = mask; bits; bits &= bits - 1) {
+        int col = (i << 6) + __builtin_ctzll(bits);
+        add_support(state, row, col, -1);
+        state.trail.emplace_back(row, col);
+    }
+    state.mrv.move(row, old_size, old_size - count);
+    STAT_ADD(state.stats, pruned, count);
+    return count;
+}
+
+// Restore every value pruned since the trail had `mark` entries
+void undo(CSPState& state, size_t mark) {
+    while (state.trail.size() > mark) {
+        auto [row, col] = state.trail.back();
+        state.trail.pop_back();
+        state.domains.restore(row, col);
+        add_support(state, row, col, 1);
+        int size = state.domains.size(row);
+        state.mrv.move(row, size - 1, size);
+    }
+}
+
+// Assign col to row: the row leaves the MRV index and its values stop
+// counting as support for the remaining rows
+void assign(CSPState& state, int row, int col) {
+    state.assignment[row] = col;
+    state.assigned++;
+    state.mrv.erase(row, state.domains.size(row));
+    state.domains.for_each(row, [&](int c) { add_support(state, row, c, -1); });
+}
+
+void unassign(CSPState& state, int row) {
+    state.domains.for_each(row, [&](int c) { add_support(state, row, c, 1); });
+    state.mrv.insert(row, state.domains.size(row));
+    state.assigned--;
+    state.assignment[row] = -1;
+}
+
+// Bits i*64 .. i*64+63 of D >> k and D << k for a multi-word bitset D,
+// with k = q * 64 + b
+inline uint64_t shifted_down(const uint64_t* d, int words, int i, int q, int b) {
+    int j = i + q;
+    uint64_t lo = j < words ? d[j] >> b : 0;
+    uint64_t hi = (b != 0 && j + 1 < words) ? d[j + 1] << (64 - b) : 0;
+    return lo | hi;
+}
+
+inline uint64_t shifted_up(const uint64_t* d, int i, int q, int b) {
+    int j = i - q;
+    uint64_t lo = j >= 0 ? d[j] << b : 0;
+    uint64_t hi = (b != 0 && j - 1 >= 0) ? d[j - 1] >> (64 - b) : 0;
+    return lo | hi;
+}
+
+// Remove from row r2 every value with no support in row r1, i.e. attacked
+// by all of r1's remaining values; returns the number of values removed.
+// A value is attacked by at most 3 columns of another row, so only rows
+// with 3 or fewer values left can prune anything.
+//
+// Word-parallel: with k = |r2 - r1|, bit c of D1, D1 >> k and D1 << k says
+// whether r1 still holds c, c + k or c - k, the three columns attacking c.
+// A value is unsupported when at least |D1| of the three masks have its
+// bit set, which is an OR, majority or AND of the masks for |D1| = 1, 2, 3.
+int revise(CSPState& state, int r2, int r1) {
+    int s = state.domains.size(r1);
+    if (s == 0 || s > 3)
+        return 0;
+    
+    int words = state.domains.words;
+    int k = abs(r2 - r1);
+    int q = k >> 6;
+    int b = k & 63;
+    const uint64_t* d1 = state.domains.row(r1);
+    const uint64_t* d2 = state.domains.row(r2);
+    int removed = 0;
+    
+    for (int i = 0; i < words; ++i) {
+        if (d2[i] == 0)
+            continue;
+        uint64_t same = d1[i];
+        uint64_t down = shifted_down(d1, words, i, q, b);
+        uint64_t up = shifted_up(d1, i, q, b);
+        uint64_t attacked;
+        if (s == 1)
+            attacked = same | down | up;
+        else if (s == 2)
+            attacked = (same & down) | (same & up) | (down & up);
+        else
+            attacked = same & down & up;
+        
+        uint64_t mask = d2[i] & attacked;
+        if (mask)
+            removed += prune_word(state, r2, i, mask);
+    }
+    return removed;
+}
+
+// Level 2 forward check with arena allocator: prune the new queen's
+// attacks from every unassigned row, then, at Consistency::AC3, propagate
+// arc consistency from every row that is down to 3 or fewer values
 bool forward_check(CSPState& state, int row, int col) {
-    // Use arena allocator for temporary storage
+    // Scratch for this node only, released when the check returns
+    ArenaScope scratch(cspArena);
     vector<int, ArenaAllocatorWrapper<int>> queue(cspArena);
+    queue.reserve(state.n);
+    bool propagate = state.consistency == Consistency::AC3;
     
-    for (int r1 = row + 1; r1 < state.n; ++r1) {
-        auto& domain1 = state.domains[r1];
-        vector<int> to_remove;
-        
-        for (int c1 : domain1) {
-            if (c1 == col || abs(c1 - col) == abs(r1 - row)) {
-                to_remove.push_back(c1);
-            }
-        }
+    for (int r1 = 0; r1 < state.n; ++r1) {
+        if (r1 == row || state.assignment[r1] != -1)
+            continue;
         
-        for (int c1 : to_remove) {
-            domain1.erase(c1);
-        }
+        int k = abs(r1 - row);
+        bool changed = prune(state, r1, col);
+        if (col - k >= 0)
+            changed |= prune(state, r1, col - k);
+        if (col + k < state.n)
+            changed |= prune(state, r1, col + k);
         
-        if (domain1.empty())
+        if (state.domains.size(r1) == 0)
             return false;
-        if (!to_remove.empty())
+        if (propagate && changed && state.domains.size(r1) <= 3)
             queue.push_back(r1);
     }
     
@@ -67,124 +204,177 @@ bool forward_check(CSPState& state, int row, int col) {
         int r1 = queue.back();
         queue.pop_back();
         
-        for (int r2 = r1 + 1; r2 < state.n; ++r2) {
-            auto& domain2 = state.domains[r2];
-            vector<int> to_remove;
+        for (int r2 = 0; r2 < state.n; ++r2) {
+            if (r2 == r1 || state.assignment[r2] != -1)
+                continue;
             
-            for (int c2 : domain2) {
-                for (int c1 : state.domains[r1]) {
-                    if (c2 == c1 || abs(c2 - c1) == abs(r2 - r1)) {
-                        to_remove.push_back(c2);
-                        break;
-                    }
-                }
-            }
-            
-            for (int c2 : to_remove) {
-                domain2.erase(c2);
-            }
-            
-            if (domain2.empty())
+            STAT_ADD(state.stats, revisions, 1);
+            if (revise(state, r2, r1) == 0)
+                continue;
+            if (state.domains.size(r2) == 0)
                 return false;
-            if (!to_remove.empty())
+            if (state.domains.size(r2) <= 3)
                 queue.push_back(r2);
         }
     }
     return true;
 }
 
-// LCV: least constraining value with arena allocator
-vector<int, ArenaAllocatorWrapper<int>> sorted_lcv(const CSPState& state, int row) {
+// LCV: least constraining value with arena allocator; the ordered columns
+// are appended to state.values. A value at distance k = |r - row| in an
+// unassigned row r conflicts with col when it is col (same column),
+// col + (r - row) (same diagonal) or col - (r - row) (same anti-diagonal),
+// so the number of values col would remove is its three support counters,
+// less the 3 that col itself contributes while row is unassigned.
+void sorted_lcv(CSPState& state, int row) {
+    ArenaScope scratch(cspArena);
     vector<pair<int, int>, ArenaAllocatorWrapper<pair<int, int>>> col_constraints(cspArena);
+    col_constraints.reserve(state.domains.size(row));
     
-    for (int col : state.domains[row]) {
-        int count = 0;
-        for (int r = row + 1; r < state.n; ++r) {
-            for (int c : state.domains[r]) {
-                if (c == col || abs(c - col) == abs(r - row))
-                    ++count;
-            }
-        }
+    state.domains.for_each(row, [&](int col) {
+        int count = state.colSupport[col] + state.diagSupport[row - col + state.n - 1]
+                    + state.antiSupport[row + col] - 3;
         col_constraints.push_back({ count, col });
-    }
+    });
     
-    sort(col_constraints.begin(), col_constraints.end());
-    vector<int, ArenaAllocatorWrapper<int>> sorted_cols(cspArena);
+    int n = state.n;
+    sort(col_constraints.begin(), col_constraints.end(), [n](const pair<int, int>& a, const pair<int, int>& b) {
+        if (a.first != b.first)
+            return a.first < b.first;
+        int da = centre_distance(n, a.second), db = centre_distance(n, b.second);
+        return da != db ? da < db : a.second < b.second;
+    });
     for (auto& pair : col_constraints)
-        sorted_cols.push_back(pair.second);
-    return sorted_cols;
+        state.values.push_back(pair.second);
+}
+
+// Row's values appended to state.values from the middle column outwards.
+// With the MRV tiebreak above this solves N = 500 without a backtrack; LCV
+// order stalled at N = 700, 1024, 1050, 1100 and 2048 in the same sweep.
+void sorted_centre(CSPState& state, int row) {
+    size_t first = state.values.size();
+    state.domains.for_each(row, [&](int col) {
+        state.values.push_back(col);
+    });
+    int n = state.n;
+    sort(state.values.begin() + first, state.values.end(), [n](int a, int b) {
+        int da = centre_distance(n, a), db = centre_distance(n, b);
+        return da != db ? da < db : a < b;
+    });
+}
+
+int select_variable(CSPState& state) {
+    return state.mrv.select();
 }
 
-int select_variable(const CSPState& state) {
-    int min_domain_size = state.n + 1;
-    int best_row = -1;
-    int max_constraints = -1;
+enum class SearchStatus { Solved, Exhausted, Paused };
+
+// Open a frame for the next MRV row with its ordered values
+void push_frame(CSPState& state) {
+    Frame frame;
+    frame.row = select_variable(state);
+    frame.first = state.values.size();
+    if (state.valueOrder == ValueOrder::LeastConstraining)
+        sorted_lcv(state, frame.row);
+    else
+        sorted_centre(state, frame.row);
+    frame.next = frame.first;
+    frame.end = state.values.size();
+    frame.mark = state.trail.size();
+    frame.active = false;
+    state.stack.push_back(frame);
+}
+
+// Iterative backtracking over an explicit stack. Runs until a solution is
+// found, the tree is exhausted, or `max_nodes` more candidates have been
+// tried (negative = no limit). A Paused search leaves the stack intact and
+// resumes where it stopped on the next call.
+SearchStatus search(CSPState& state, long long max_nodes) {
+    if (state.assigned == state.n)
+        return SearchStatus::Solved;
+    if (state.stack.empty()) {
+        if (state.nodes > 0)
+            return SearchStatus::Exhausted;
+        push_frame(state);
+    }
     
-    for (int row = 0; row < state.n; ++row) {
-        if (state.assignment[row] != -1)
-            continue;
-            
-        int domain_size = state.domains[row].size();
-        if (domain_size < min_domain_size) {
-            min_domain_size = domain_size;
-            best_row = row;
+    long long budget_end = max_nodes < 0 ? -1 : state.nodes + max_nodes;
+    while (!state.stack.empty()) {
+        Frame& frame = state.stack.back();
+        if (frame.active) {
+            undo(state, frame.mark);
+            unassign(state, frame.row);
+            frame.active = false;
         }
-        else if (domain_size == min_domain_size) {
-            int constraints = 0;
-            for (int other = 0; other < state.n; ++other) {
-                if (other != row && state.assignment[other] == -1) {
-                    constraints += state.domains[other].size();
-                }
-            }
-            if (constraints > max_constraints) {
-                max_constraints = constraints;
-                best_row = row;
-            }
+        
+        if (frame.next == frame.end) {
+            STAT_ADD(state.stats, backtracks, 1);
+            state.values.resize(frame.first);
+            state.stack.pop_back();
+            continue;
         }
-    } 
-    return best_row;
+        if (state.nodes == budget_end)
+            return SearchStatus::Paused;
+        
+        int col = state.values[frame.next++];
+        frame.mark = state.trail.size();
+        frame.active = true;
+        assign(state, frame.row, col);
+        state.nodes++;
+        
+        if (!forward_check(state, frame.row, col))
+            continue;
+        if (state.assigned == state.n)
+            return SearchStatus::Solved;
+        push_frame(state);
+    }
+    return SearchStatus::Exhausted;
 }
 
 bool solve(CSPState& state) {
-    bool done = true;
-    for (int i = 0; i < state.n; ++i)
-        if (state.assignment[i] == -1)
-            done = false;
-    if (done) return true;
-    
-    int row = select_variable(state);
-    vector<int, ArenaAllocatorWrapper<int>> values = sorted_lcv(state, row);
-    
-    for (int col : values) {
-        CSPState new_state = state;
-        new_state.assignment[row] = col;
-        
-        if (!forward_check(new_state, row, col))
-            continue;
-        
-        if (solve(new_state)) {
-            state = new_state;
-            return true;
-        }
-    } 
-    return false;
+    return search(state, -1) == SearchStatus::Solved;
 }
 
-double dfs_csp(int n) {
+long long cspNodeBudget = 1000000;
+Consistency cspConsistency = Consistency::AC3;
+ValueOrder cspValueOrder = ValueOrder::Centre;
+ArenaOptions cspArenaOptions;
+
+double dfs_csp(int n, bool& solved, SearchStats& stats) {
     #ifdef TRACK_MEMORY
     MemoryTracker::reset();
     MemoryTracker::enable();
+    MemoryTracker::markPhase("csp N=" + to_string(n) + " search");
     #endif
     
-    CSPState state(n);
-    for (int i = 0; i < n; ++i) {
-        for (int j = 0; j < n; ++j) {
-            state.domains[i].insert(j);
-        }
-    }
+    cspBoardArena.setOptions(cspArenaOptions);
+    stats = SearchStats();
     
+    // Randomized restarts: each attempt gets twice the nodes of the one
+    // before, starting from one node per row, until the budget is spent
     auto start = high_resolution_clock::now();
-    bool solved = solve(state);
+    SearchStatus status = SearchStatus::Paused;
+    long long limit = n;
+    int depth = 0;
+    for (int attempt = 0; status == SearchStatus::Paused; ++attempt) {
+        long long left = cspNodeBudget < 0 ? limit : cspNodeBudget - static_cast<long long>(stats.nodes);
+        if (left <= 0)
+            break;
+        {
+            CSPState state(n, attempt > 0);
+            state.consistency = cspConsistency;
+            state.valueOrder = cspValueOrder;
+            status = search(state, min(limit, left));
+            stats.merge(state.stats);
+            stats.nodes += state.nodes;
+            depth = state.stack.size();
+        }
+        cspBoardArena.reset();
+        if (status == SearchStatus::Paused)
+            stats.restarts++;
+        limit *= 2;
+    }
+    solved = status == SearchStatus::Solved;
     auto end = high_resolution_clock::now();
     duration<double> elapsed = end - start;
     
@@ -194,39 +384,85 @@ double dfs_csp(int n) {
     MemoryTracker::analyzeFragmentation();
     #endif
     
-    cspArena.reset();
-    
-    if (!solved) {
+    if (status == SearchStatus::Exhausted) {
         cerr << "CSP solver failed for N = " << n << endl;
+    } else if (status == SearchStatus::Paused) {
+        cerr << "CSP solver gave up for N = " << n << " after " << stats.nodes
+             << " nodes and " << stats.restarts << " restarts, last at depth " << depth << endl;
     }
     
     return elapsed.count();
 }
 
-int main() {
+#ifndef NQUEENS_UNIFIED
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--max-nodes") == 0 && i + 1 < argc) {
+            cspNodeBudget = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--consistency") == 0 && i + 1 < argc) {
+            string level = argv[++i];
+            if (level == "fc") cspConsistency = Consistency::ForwardCheck;
+            else if (level == "ac3") cspConsistency = Consistency::AC3;
+            else {
+                cerr << "Unknown consistency level: " << level << "\n";
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--values") == 0 && i + 1 < argc) {
+            string order = argv[++i];
+            if (order == "centre") cspValueOrder = ValueOrder::Centre;
+            else if (order == "lcv") cspValueOrder = ValueOrder::LeastConstraining;
+            else {
+                cerr << "Unknown value order: " << order << "\n";
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--arena") == 0 && i + 1 < argc) {
+            string backing = argv[++i];
+            if (backing == "heap") cspArenaOptions.backing = ArenaBacking::Heap;
+            else if (backing == "thp") cspArenaOptions.backing = ArenaBacking::HugePages;
+            else if (backing == "hugetlb") cspArenaOptions.backing = ArenaBacking::HugeTLB;
+            else {
+                cerr << "Unknown arena backing: " << backing << "\n";
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--numa-node") == 0 && i + 1 < argc) {
+            cspArenaOptions.numaNode = atoi(argv[++i]);
+        } else {
+            cerr << "Usage: " << argv[0] << " [--max-nodes N] [--consistency fc|ac3]\n"
+                 << "       [--values centre|lcv] [--arena heap|thp|hugetlb] [--numa-node K]\n";
+            return 1;
+        }
+    }
+    
     vector <int> TstValues = { 4, 8, 16, 32, 64, 128, 256, 512, 1024 };
     
     #ifdef TRACK_MEMORY
     cout << "Memory tracking ENABLED for CSP\n";
+    MemoryTracker::startTimeline();
     #endif
     
     ofstream csv("nqueens_csp_results.csv");
-    csv << "N,Time(seconds)\n";
+    csv << "N,Time(seconds),Solved\n";
     cout << "DFS - CSP searching...\n";
     
     for (int n : TstValues) {
         cout << "Running for N = " << n << "...\n";
-        double time_taken = dfs_csp(n);
+        bool solved = false;
+        SearchStats stats;
+        double time_taken = dfs_csp(n, solved, stats);
         cout << "Time taken: " << time_taken << " seconds\n";
-        csv << n << "," << time_taken << "\n";
+        csv << n << "," << time_taken << "," << solved << "\n";
     }
     
     csv.close();
     
     #ifdef TRACK_MEMORY
+    MemoryTracker::stopTimeline();
+    MemoryTracker::exportTimelineCSV("csp_timeline.csv");
+    MemoryTracker::exportChromeTrace("csp_timeline.json");
     MemoryTracker::generateLeakReport("csp_final_leaks.txt");
     #endif
     
     cout << "Results saved to nqueens_csp_results.csv\n";
     return 0;
-}
\ No newline at end of file
+}
+#endif // NQUEENS_UNIFIED
\ No newline at end of file
@@ -0,0 +1,31 @@
+#ifndef NQUEENS_CSP_H
+#define NQUEENS_CSP_H
+
+#include "searchstats.h"
+#include "memory/arenaallocator.h"
+
+// How much propagation forward_check() does after an assignment
+enum class Consistency {
+    ForwardCheck,  // prune the new queen's attacks only
+    AC3            // then make every pair of unassigned rows arc consistent
+};
+
+// Order in which a row's remaining values are tried
+enum class ValueOrder {
+    Centre,            // middle column outwards
+    LeastConstraining  // fewest values removed from other rows first (LCV)
+};
+
+// Candidates tried before dfs_csp() gives up on a board size
+extern long long cspNodeBudget;
+extern Consistency cspConsistency;
+extern ValueOrder cspValueOrder;
+// Backing of the arena holding the domain bitsets (not the per-node scratch)
+extern ArenaOptions cspArenaOptions;
+
+// Finds one solution with MRV + propagation and randomized restarts;
+// returns seconds taken.
+// stats.nodes is always filled, the other counters only with TRACK_STATS.
+double dfs_csp(int n, bool& solved, SearchStats& stats);
+
+#endif // NQUEENS_CSP_H
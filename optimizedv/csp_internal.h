@@ -0,0 +1,227 @@
+#ifndef NQUEENS_CSP_INTERNAL_H
+#define NQUEENS_CSP_INTERNAL_H
+
+// The CSP solver's state and search steps, shared by csp.cpp and the tests
+// that check them; drivers only need csp.h
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+#include "memory/memorypool.h"
+#include "memory/arenaallocator.h"
+#include "csp.h"
+
+// Domain bitsets of the board being solved; dfs_csp() rewinds it after each
+// attempt, the tests after each board
+extern ArenaAllocator cspBoardArena;
+
+// Bitsets sized once per board, drawn from cspBoardArena so large boards can
+// be backed by huge pages
+using ArenaBits = std::vector<uint64_t, ArenaAllocatorWrapper<uint64_t>>;
+
+// Dense bitset domains: row r owns words [r * words, (r + 1) * words) of
+// `bits`, with bit c set while column c is still legal for row r. Sizes are
+// cached so MRV does not have to popcount every row on every decision.
+struct BitDomains {
+    int n;
+    int words;
+    ArenaBits bits;
+    std::vector<int> sizes;
+    
+    BitDomains(int size);
+    
+    uint64_t* row(int r) { return bits.data() + r * words; }
+    const uint64_t* row(int r) const { return bits.data() + r * words; }
+    
+    bool has(int r, int c) const {
+        return (row(r)[c >> 6] >> (c & 63)) & 1;
+    }
+    
+    // Clears column c from row r's domain; returns false if it was not there
+    bool remove(int r, int c) {
+        uint64_t& word = row(r)[c >> 6];
+        uint64_t bit = 1ULL << (c & 63);
+        if (!(word & bit))
+            return false;
+        word &= ~bit;
+        sizes[r]--;
+        return true;
+    }
+    
+    // Clears the set bits of `mask` (all present) from word i of row r
+    int remove_mask(int r, int i, uint64_t mask) {
+        row(r)[i] &= ~mask;
+        int count = __builtin_popcountll(mask);
+        sizes[r] -= count;
+        return count;
+    }
+    
+    // Puts back a column previously cleared by remove()
+    void restore(int r, int c) {
+        row(r)[c >> 6] |= 1ULL << (c & 63);
+        sizes[r]++;
+    }
+    
+    int size(int r) const { return sizes[r]; }
+    
+    // Recount row r after word-level updates
+    int recount(int r) {
+        int count = 0;
+        const uint64_t* w = row(r);
+        for (int i = 0; i < words; ++i)
+            count += __builtin_popcountll(w[i]);
+        sizes[r] = count;
+        return count;
+    }
+    
+    void fill_all() {
+        for (int r = 0; r < n; ++r) {
+            uint64_t* w = row(r);
+            for (int i = 0; i < words; ++i)
+                w[i] = ~0ULL;
+            if (n & 63)
+                w[words - 1] = (1ULL << (n & 63)) - 1;
+            sizes[r] = n;
+        }
+    }
+    
+    // Call f(c) for every column left in row r, in increasing order
+    template<typename F>
+    void for_each(int r, F f) const {
+        const uint64_t* w = row(r);
+        for (int i = 0; i < words; ++i) {
+            uint64_t word = w[i];
+            while (word) {
+                f((i << 6) + __builtin_ctzll(word));
+                word &= word - 1;
+            }
+        }
+    }
+};
+
+// One decision on the explicit search stack: the row being assigned, its
+// ordered candidates values[first, end) in CSPState::values, and the
+// trail length to rewind to when the current candidate is retracted
+struct Frame {
+    int row;
+    size_t first;
+    size_t next;
+    size_t end;
+    size_t mark;
+    bool active;  // values[next - 1] is currently assigned to row
+};
+
+// MRV index over the unassigned rows: a doubly linked list of rows per
+// domain size, O(n) in all. Rows join a bucket at the back, so among the
+// rows with the fewest values the one that has had that many longest is
+// picked. Picking the most recently narrowed row instead stalled at
+// N = 900, 950, 1024 and 2048 with a 200000-node budget.
+struct MRVIndex {
+    int n;
+    int min_size;       // no non-empty bucket below this
+    std::vector<int> head;   // first and last row of each bucket, -1 when empty
+    std::vector<int> tail;
+    std::vector<int> next;
+    std::vector<int> prev;
+    
+    MRVIndex(int size)
+        : n(size), min_size(size + 1), head(size + 1, -1), tail(size + 1, -1), next(size), prev(size) {}
+    
+    void insert(int row, int size) {
+        prev[row] = tail[size];
+        next[row] = -1;
+        if (tail[size] != -1)
+            next[tail[size]] = row;
+        else
+            head[size] = row;
+        tail[size] = row;
+        if (size < min_size)
+            min_size = size;
+    }
+    
+    void erase(int row, int size) {
+        if (prev[row] != -1)
+            next[prev[row]] = next[row];
+        else
+            head[size] = next[row];
+        if (next[row] != -1)
+            prev[next[row]] = prev[row];
+        else
+            tail[size] = prev[row];
+    }
+    
+    void move(int row, int from, int to) {
+        erase(row, from);
+        insert(row, to);
+    }
+    
+    // Unassigned row with the smallest domain, longest in its bucket first
+    int select() {
+        while (min_size <= n && head[min_size] == -1)
+            ++min_size;
+        return min_size > n ? -1 : head[min_size];
+    }
+};
+
+// Twice the distance of column (or row) i from the middle of the board
+inline int centre_distance(int n, int i) {
+    return std::abs(2 * i - (n - 1));
+}
+
+struct CSPState {
+    int n;
+    Consistency consistency = Consistency::AC3;
+    ValueOrder valueOrder = ValueOrder::Centre;
+    int assigned = 0;
+    long long nodes = 0;  // candidate assignments tried so far
+    SearchStats stats;
+    std::vector<int, MemoryPoolAllocator<int>> assignment;
+    BitDomains domains;
+    MRVIndex mrv;
+    // Live values of the unassigned rows on each column, diagonal
+    // (row - col + n - 1) and anti-diagonal (row + col), for O(1) LCV scores
+    std::vector<int> colSupport;
+    std::vector<int> diagSupport;
+    std::vector<int> antiSupport;
+    // Undo log of every (row, col) pruned from the domains, in order; the
+    // search mutates one state and rewinds the trail on backtrack
+    std::vector<std::pair<int, int>> trail;
+    // Decision stack and the candidate values of all its frames; both are
+    // preallocated, so a search step allocates nothing and the current
+    // path can be inspected between search() calls
+    std::vector<Frame> stack;
+    std::vector<int> values;
+    
+    // Starts with every column legal for every row. The rows enter the MRV
+    // index, and so break its first ties, from the edges inwards; restarts
+    // shuffle them instead.
+    CSPState(int size, bool shuffled);
+};
+
+// Add `delta` to the support counters of value col of row
+inline void add_support(CSPState& state, int row, int col, int delta) {
+    state.colSupport[col] += delta;
+    state.diagSupport[row - col + state.n - 1] += delta;
+    state.antiSupport[row + col] += delta;
+}
+
+// Domain updates, each recorded on the trail so undo() can rewind it, and
+// the bookkeeping of a row's assignment
+bool prune(CSPState& state, int row, int col);
+int prune_word(CSPState& state, int row, int i, uint64_t mask);
+void undo(CSPState& state, size_t mark);
+void assign(CSPState& state, int row, int col);
+void unassign(CSPState& state, int row);
+
+// Propagation after an assignment; revise() is one arc of AC-3
+int revise(CSPState& state, int r2, int r1);
+bool forward_check(CSPState& state, int row, int col);
+
+// Value orders: append row's values to state.values
+void sorted_lcv(CSPState& state, int row);
+void sorted_centre(CSPState& state, int row);
+
+#endif // NQUEENS_CSP_INTERNAL_H
@@ -2,11 +2,18 @@
 #include <vector>
 #include <chrono>
 #include <fstream>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 // Memory management includes
-#include "src/memory/memorytracker.h"
-#include "src/memory/memorypool.h"
-#include "src/memory/arenaallocator.h"
+#include "memory/memorytracker.h"
+#include "memory/memorypool.h"
+
+#include "dfs.h"
 
 using namespace std;
 using namespace std::chrono;
@@ -14,7 +21,9 @@ using namespace std::chrono;
 // Global memory pools
 namespace {
     MemoryPool dfsBoardPool(sizeof(vector<int>), 1000);
-    ArenaAllocator dfsArena(4096);
+    // Deque blocks of the work-stealing queues, freed by whichever worker
+    // drains them
+    MemoryPool dfsTaskPool(512, 0);
 }
 
 template <typename Allocator>
@@ -23,76 +32,427 @@ bool is_safe(const vector<int, Allocator>& assignment, int row, int col) {
         int c = assignment[r];
         if (c == col || abs(c - col) == abs(r - row))
             return false;
-    } 
+    }
     return true;
 }
 
-// Backtracking function using memory pool
-void solve_all(vector<int, MemoryPoolAllocator<int>>& board, int row, int n, int& count) {
+// Backtracking function using memory pool. Iterative: board[r] holds the
+// column being tried in each row of the current path, so the board itself
+// is the decision stack and search depth is not bounded by the call stack.
+void solve_all(vector<int, MemoryPoolAllocator<int>>& board, int row, int n, uint64_t& count,
+               SearchStats& stats) {
     if (row == n) {
         count++;
         return;
     }
     
-    for (int col = 0; col < n; ++col) {
-        if (is_safe(board, row, col)) {
-            board[row] = col;
-            solve_all(board, row + 1, n, count);
+    int start = row;
+    board[row] = -1;
+    while (row >= start) {
+        int col = board[row] + 1;
+        while (col < n && !is_safe(board, row, col))
+            ++col;
+        
+        if (col == n) {
+            STAT_ADD(stats, backtracks, 1);
+            board[row] = -1;
+            --row;
+            continue;
         }
+        
+        board[row] = col;
+        STAT_ADD(stats, nodes, 1);
+        if (row == n - 1) {
+            count++;
+        } else {
+            board[++row] = -1;
+        }
+    }
+}
+
+// Bitboard backtracking: bit c of cols/ld/rd is set when column c of the
+// current row is attacked by an earlier queen (same column, left diagonal,
+// right diagonal). Candidates are enumerated lowest set bit first.
+void solve_all_bits(uint64_t full, uint64_t cols, uint64_t ld, uint64_t rd, uint64_t& count,
+                    SearchStats& stats) {
+    if (cols == full) {
+        count++;
+        return;
+    }
+    
+    uint64_t avail = full & ~(cols | ld | rd);
+    if (!avail)
+        STAT_ADD(stats, backtracks, 1);
+    while (avail) {
+        uint64_t bit = avail & (~avail + 1);
+        avail ^= bit;
+        STAT_ADD(stats, nodes, 1);
+        solve_all_bits(full, cols | bit, (ld | bit) << 1, (rd | bit) >> 1, count, stats);
     }
 }
 
-double dfs_blind(int n, int& solution_count) {
+// TRACK_MEMORY bookkeeping around one solve of any engine: a fresh
+// tracker and a timeline phase before, a dfs_memory_N<n>.txt report after
+void track_solve_begin(const char* engine, int n) {
     #ifdef TRACK_MEMORY
     MemoryTracker::reset();
     MemoryTracker::enable();
+    MemoryTracker::markPhase(string("dfs ") + engine + " N=" + to_string(n));
     #endif
-    
+}
+
+void track_solve_end(int n) {
+    #ifdef TRACK_MEMORY
+    string filename = "dfs_memory_N" + to_string(n) + ".txt";
+    MemoryTracker::generateReport(filename);
+    MemoryTracker::analyzeFragmentation();
+    #endif
+}
+
+// The baseline engine: every column of every row is checked against the
+// queens placed so far, with no bit tricks or symmetry
+double dfs_blind(int n, uint64_t& solution_count, SearchStats& stats) {
+    track_solve_begin("blind", n);
     vector<int, MemoryPoolAllocator<int>> board(dfsBoardPool);
     board.resize(n, -1);
     solution_count = 0;
     
     auto start = high_resolution_clock::now();
-    solve_all(board, 0, n, solution_count);
+    solve_all(board, 0, n, solution_count, stats);
     auto end = high_resolution_clock::now();
     duration<double> duration = end - start;
+    track_solve_end(n);
     
-    #ifdef TRACK_MEMORY
-    string filename = "dfs_memory_N" + to_string(n) + ".txt";
-    MemoryTracker::generateReport(filename);
-    MemoryTracker::analyzeFragmentation();
-    #endif
+    return duration.count();
+}
+
+// Same search as dfs_blind() on 64-bit masks, so n is limited to 64
+double dfs_bitboard(int n, uint64_t& solution_count, SearchStats& stats) {
+    solution_count = 0;
+    if (n < 1 || n > 64) {
+        cerr << "Bitboard DFS supports 1 <= N <= 64, got N = " << n << endl;
+        return 0.0;
+    }
+    
+    uint64_t full = (n == 64) ? ~0ULL : (1ULL << n) - 1;
     
-    dfsArena.reset(); // Clean up arena
+    track_solve_begin("bitboard", n);
+    auto start = high_resolution_clock::now();
+    solve_all_bits(full, 0, 0, 0, solution_count, stats);
+    auto end = high_resolution_clock::now();
+    duration<double> duration = end - start;
+    track_solve_end(n);
     
     return duration.count();
 }
 
-int main() {
-    vector<int> TstValues = { 4, 8, 16, 32, 64, 128, 256, 512, 1024 };
+// A solution is fundamental when it is the lexicographically smallest of
+// its 8 D4 images; queens[r] is the column of the queen in row r.
+bool is_canonical(const int* queens, int n) {
+    int image[64];
+    for (int t = 1; t < 8; ++t) {
+        for (int r = 0; r < n; ++r) {
+            int c = queens[r];
+            switch (t) {
+                case 1: image[c] = n - 1 - r; break;          // rotate 90
+                case 2: image[n - 1 - r] = n - 1 - c; break;  // rotate 180
+                case 3: image[n - 1 - c] = r; break;          // rotate 270
+                case 4: image[r] = n - 1 - c; break;          // mirror columns
+                case 5: image[n - 1 - r] = c; break;          // mirror rows
+                case 6: image[c] = r; break;                  // transpose
+                case 7: image[n - 1 - c] = n - 1 - r; break;  // anti-transpose
+            }
+        }
+        if (lexicographical_compare(image, image + n, queens, queens + n))
+            return false;
+    }
+    return true;
+}
+
+// Bitboard search that also records the board so leaves can be
+// canonicalized; weight is how many solutions each leaf stands for
+void solve_canonical_bits(int n, uint64_t full, int row, uint64_t cols, uint64_t ld, uint64_t rd,
+                          uint64_t weight, int* queens, SymmetryCounts& counts) {
+    if (cols == full) {
+        counts.total += weight;
+        if (is_canonical(queens, n))
+            counts.unique++;
+        return;
+    }
+    
+    uint64_t avail = full & ~(cols | ld | rd);
+    if (!avail)
+        STAT_ADD(counts.stats, backtracks, 1);
+    while (avail) {
+        uint64_t bit = avail & (~avail + 1);
+        avail ^= bit;
+        STAT_ADD(counts.stats, nodes, 1);
+        queens[row] = __builtin_ctzll(bit);
+        solve_canonical_bits(n, full, row + 1, cols | bit, (ld | bit) << 1, (rd | bit) >> 1,
+                             weight, queens, counts);
+    }
+}
+
+const int MaxSplitDepth = 8;
+
+// One subtree of the search: the masks and queens after the first `row`
+// placements. weight is 2 when the subtree also stands for its mirror image.
+struct PrefixTask {
+    uint64_t cols = 0;
+    uint64_t ld = 0;
+    uint64_t rd = 0;
+    uint64_t weight = 1;
+    int row = 0;
+    uint8_t queens[MaxSplitDepth];
+};
+
+// Enumerate every safe placement of `depth` more queens below `prefix`
+void collect_prefixes(uint64_t full, int depth, const PrefixTask& prefix, vector<PrefixTask>& tasks) {
+    if (depth == 0 || prefix.cols == full) {
+        tasks.push_back(prefix);
+        return;
+    }
+    
+    uint64_t avail = full & ~(prefix.cols | prefix.ld | prefix.rd);
+    while (avail) {
+        uint64_t bit = avail & (~avail + 1);
+        avail ^= bit;
+        PrefixTask next = prefix;
+        next.cols = prefix.cols | bit;
+        next.ld = (prefix.ld | bit) << 1;
+        next.rd = (prefix.rd | bit) >> 1;
+        next.queens[next.row++] = __builtin_ctzll(bit);
+        collect_prefixes(full, depth - 1, next, tasks);
+    }
+}
+
+// Split the tree after `depth` queens. With symmetry breaking the first
+// queen only goes in the left half of row 0 and each subtree is counted
+// twice for its mirror image; the middle column of an odd board is
+// searched once, as it is its own mirror.
+void split_tree(int n, uint64_t full, int depth, bool symmetric, vector<PrefixTask>& tasks) {
+    PrefixTask root;
+    if (!symmetric) {
+        collect_prefixes(full, depth, root, tasks);
+        return;
+    }
+    
+    for (int col = 0; col < (n + 1) / 2; ++col) {
+        uint64_t bit = 1ULL << col;
+        PrefixTask first = root;
+        first.cols = bit;
+        first.ld = bit << 1;
+        first.rd = bit >> 1;
+        first.weight = (n % 2 == 1 && col == n / 2) ? 1 : 2;
+        first.queens[first.row++] = col;
+        collect_prefixes(full, depth - 1, first, tasks);
+    }
+}
+
+// Count the subtree below a prefix, scaled by its symmetry weight
+void count_prefix(int n, uint64_t full, const PrefixTask& task, bool count_unique, SymmetryCounts& counts) {
+    if (!count_unique) {
+        uint64_t count = 0;
+        solve_all_bits(full, task.cols, task.ld, task.rd, count, counts.stats);
+        counts.total += count * task.weight;
+        return;
+    }
+    
+    int queens[64];
+    copy(task.queens, task.queens + task.row, queens);
+    solve_canonical_bits(n, full, task.row, task.cols, task.ld, task.rd, task.weight, queens, counts);
+}
+
+// Symmetry-reduced count of all solutions; with count_unique the
+// fundamental solutions are counted too (this requires recording boards)
+double dfs_symmetric(int n, bool count_unique, SymmetryCounts& counts) {
+    counts = SymmetryCounts();
+    if (n < 1 || n > 64) {
+        cerr << "Bitboard DFS supports 1 <= N <= 64, got N = " << n << endl;
+        return 0.0;
+    }
+    
+    uint64_t full = (n == 64) ? ~0ULL : (1ULL << n) - 1;
+    
+    track_solve_begin("symmetric", n);
+    auto start = high_resolution_clock::now();
+    vector<PrefixTask> roots;
+    split_tree(n, full, 1, true, roots);
+    for (const auto& root : roots)
+        count_prefix(n, full, root, count_unique, counts);
+    auto end = high_resolution_clock::now();
+    duration<double> duration = end - start;
+    track_solve_end(n);
+    
+    return duration.count();
+}
+
+// Per-worker task deque: the owner pops from the back, thieves take from
+// the front. Aligned so neighbouring workers' counters never share a line.
+struct alignas(64) WorkerQueue {
+    mutex lock;
+    deque<PrefixTask, MemoryPoolAllocator<PrefixTask>> tasks{MemoryPoolAllocator<PrefixTask>(dfsTaskPool)};
+    SymmetryCounts counts;
+};
+
+bool pop_task(WorkerQueue& queue, bool steal, PrefixTask& task) {
+    lock_guard<mutex> guard(queue.lock);
+    if (queue.tasks.empty())
+        return false;
+    
+    if (steal) {
+        task = queue.tasks.front();
+        queue.tasks.pop_front();
+    } else {
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+    }
+    return true;
+}
+
+void count_worker(vector<WorkerQueue>& queues, size_t id, int n, uint64_t full, bool count_unique) {
+    WorkerQueue& own = queues[id];
+    SymmetryCounts counts;
+    PrefixTask task;
+    
+    for (;;) {
+        bool found = pop_task(own, false, task);
+        for (size_t k = 1; !found && k < queues.size(); ++k)
+            found = pop_task(queues[(id + k) % queues.size()], true, task);
+        // No task is created after start-up, so empty queues mean we are done
+        if (!found)
+            break;
+        count_prefix(n, full, task, count_unique, counts);
+    }
+    own.counts = counts;
+}
+
+// Split the tree after `split_depth` queens and count the subtrees on a
+// work-stealing pool of `threads` workers (0 = one per hardware thread)
+double dfs_parallel(int n, int threads, int split_depth, bool symmetric, bool count_unique,
+                    SymmetryCounts& counts) {
+    counts = SymmetryCounts();
+    if (n < 1 || n > 64) {
+        cerr << "Parallel DFS supports 1 <= N <= 64, got N = " << n << endl;
+        return 0.0;
+    }
+    if (threads <= 0)
+        threads = max(1u, thread::hardware_concurrency());
+    split_depth = max(symmetric ? 1 : 0, min(split_depth, MaxSplitDepth));
+    
+    uint64_t full = (n == 64) ? ~0ULL : (1ULL << n) - 1;
+    
+    track_solve_begin("parallel", n);
+    auto start = high_resolution_clock::now();
+    
+    vector<PrefixTask> tasks;
+    split_tree(n, full, split_depth, symmetric, tasks);
+    
+    vector<WorkerQueue> queues(threads);
+    for (size_t i = 0; i < tasks.size(); ++i)
+        queues[i % threads].tasks.push_back(tasks[i]);
+    
+    vector<thread> workers;
+    workers.reserve(threads);
+    for (int id = 0; id < threads; ++id)
+        workers.emplace_back(count_worker, ref(queues), id, n, full, count_unique);
+    for (auto& worker : workers)
+        worker.join();
+    
+    for (const auto& queue : queues) {
+        counts.total += queue.counts.total;
+        counts.unique += queue.counts.unique;
+        counts.stats.merge(queue.counts.stats);
+    }
+    
+    auto end = high_resolution_clock::now();
+    duration<double> duration = end - start;
+    track_solve_end(n);
+    
+    return duration.count();
+}
+
+#ifndef NQUEENS_UNIFIED
+int main(int argc, char** argv) {
+    int threads = 0;
+    int split_depth = 3;
+    bool symmetric = true;
+    bool count_unique = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--split-depth") == 0 && i + 1 < argc) {
+            split_depth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--no-symmetry") == 0) {
+            symmetric = false;
+        } else if (strcmp(argv[i], "--unique") == 0) {
+            count_unique = true;
+        } else {
+            cerr << "Usage: " << argv[0]
+                 << " [--threads T] [--split-depth K] [--no-symmetry] [--unique]\n";
+            return 1;
+        }
+    }
+    if (threads <= 0)
+        threads = max(1u, thread::hardware_concurrency());
+    // Fundamental solutions are only counted on the symmetry-reduced tree
+    if (count_unique)
+        symmetric = true;
+    
+    // Counting all solutions is exponential; past N = 20 a sweep no longer
+    // finishes in reasonable time even with the bitboard engine.
+    vector<int> TstValues = { 4, 8, 10, 12, 14, 16, 18, 20 };
     
     #ifdef TRACK_MEMORY
     cout << "Memory tracking ENABLED for DFS\n";
+    MemoryTracker::startTimeline();
     #endif
     
     ofstream csv("nqueens_dfs_results.csv");
-    csv << "N,Time(seconds),Solutions\n";
-    cout << "DFS - blindly searching all solutions for N-Queens...\n";
+    csv << "N,Time(seconds),Solutions,Unique,Threads,ParallelTime(seconds),Speedup\n";
+    cout << "DFS - counting all solutions for N-Queens...\n";
+    cout << "Parallel runs use " << threads << " threads, split depth " << split_depth << "\n";
+    cout << "Symmetry breaking " << (symmetric ? "ON" : "OFF")
+         << ", unique solutions " << (count_unique ? "ON" : "OFF") << "\n";
     
     for (int n : TstValues) {
         cout << "Running for N = " << n << "...\n";
-        int solution_count = 0;
-        double time_taken = dfs_blind(n, solution_count);
-        cout << "Time taken: " << time_taken << " seconds, Solutions: " << solution_count << "\n";
-        csv << n << "," << time_taken << "," << solution_count << "\n";
+        SymmetryCounts counts;
+        double time_taken;
+        if (symmetric) {
+            time_taken = dfs_symmetric(n, count_unique, counts);
+        } else {
+            time_taken = dfs_bitboard(n, counts.total, counts.stats);
+        }
+        cout << "Time taken: " << time_taken << " seconds, Solutions: " << counts.total;
+        if (count_unique)
+            cout << ", Unique: " << counts.unique;
+        cout << "\n";
+        
+        SymmetryCounts parallel_counts;
+        double parallel_time = dfs_parallel(n, threads, split_depth, symmetric, count_unique, parallel_counts);
+        double speedup = parallel_time > 0 ? time_taken / parallel_time : 0.0;
+        cout << "Parallel time: " << parallel_time << " seconds, Speedup: " << speedup << "x\n";
+        if (parallel_counts.total != counts.total || parallel_counts.unique != counts.unique) {
+            cerr << "Parallel count mismatch for N = " << n << ": " << parallel_counts.total << endl;
+        }
+        
+        csv << n << "," << time_taken << "," << counts.total << ",";
+        if (count_unique)
+            csv << counts.unique;
+        csv << "," << threads << "," << parallel_time << "," << speedup << "\n";
     }
     
     csv.close();
     
     #ifdef TRACK_MEMORY
+    MemoryTracker::stopTimeline();
+    MemoryTracker::exportTimelineCSV("dfs_timeline.csv");
+    MemoryTracker::exportChromeTrace("dfs_timeline.json");
     MemoryTracker::generateLeakReport("dfs_final_leaks.txt");
     #endif
     
     cout << "Results saved to nqueens_dfs_results.csv\n";
     return 0;
-}
\ No newline at end of file
+}
+#endif // NQUEENS_UNIFIED
\ No newline at end of file
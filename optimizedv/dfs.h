@@ -0,0 +1,25 @@
+#ifndef NQUEENS_DFS_H
+#define NQUEENS_DFS_H
+
+#include <cstdint>
+
+#include "searchstats.h"
+
+// Total solutions and fundamental ones (distinct up to the 8 rotations and
+// reflections of the board)
+struct SymmetryCounts {
+    uint64_t total = 0;
+    uint64_t unique = 0;
+    SearchStats stats;  // below the split rows, which are enumerated up front
+};
+
+// Every solver returns its wall time in seconds. The bitboard engines need
+// N <= 64; the parallel one splits the first `split_depth` rows into tasks.
+// dfs_blind() is the unoptimized baseline they are measured against.
+double dfs_blind(int n, uint64_t& solution_count, SearchStats& stats);
+double dfs_bitboard(int n, uint64_t& solution_count, SearchStats& stats);
+double dfs_symmetric(int n, bool count_unique, SymmetryCounts& counts);
+double dfs_parallel(int n, int threads, int split_depth, bool symmetric, bool count_unique,
+                    SymmetryCounts& counts);
+
+#endif // NQUEENS_DFS_H
@@ -0,0 +1,36 @@
+#ifndef NQUEENS_LOCALSEARCH_H
+#define NQUEENS_LOCALSEARCH_H
+
+#include "searchstats.h"
+
+// Initial assignment hillClimb() starts (and restarts) from
+enum class InitStrategy {
+    Random,       // independent random column per row
+    Permutation,  // random permutation: no column conflicts
+    Greedy,       // row by row, least-conflicted column so far; O(n^2)
+    SosicGu       // permutation with diagonal-safe swaps, last rows left random
+};
+
+const char* initName(InitStrategy init);
+// Looks up an init strategy by its initName(); false if there is none
+bool parseInit(const char* name, InitStrategy& init);
+
+// How hillClimb() gets off a plateau instead of giving up
+struct RestartPolicy {
+    int max_restarts = 50;      // fresh random boards tried before reporting failure
+    int sideways_budget = 100;  // consecutive equal-cost moves allowed
+    int tabu_tenure = 10;       // steps a moved row is skipped when picking (0 = off)
+};
+
+// Outcome of one hillClimb() call, summed over all of its restarts
+struct ClimbResult {
+    bool solved = false;
+    SearchStats stats;          // restarts and moves are always counted
+    double init_seconds = 0.0;  // time spent building initial boards
+};
+
+// Min-conflicts from a fresh board; returns seconds taken
+double runHillClimbing(int n, const RestartPolicy& policy, InitStrategy init, ClimbResult& result,
+                       int max_steps = 1000000);
+
+#endif // NQUEENS_LOCALSEARCH_H
@@ -1,68 +1,590 @@
 #include <iostream>
-#include "src/memory/memorytracker.h"
+#include <fstream>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <chrono>
+#include "memory/memorytracker.h"
+#include "memory/arenaallocator.h"
+#include "memory/memorypool.h"
+
+#include "dfs.h"
+#include "csp.h"
+#include "localsearch.h"
+#include "benchmark.h"
+#include "perfcounters.h"
 
 // Simple test to verify memory tracking works
 void testMemoryTracking() {
     std::cout << "=== Memory Tracking Test ===\n";
-    
+
     MemoryTracker::enable();
     MemoryTracker::reset();
-    
+
     // Test allocations
     int* array1 = new int[100];
     double* array2 = new double[50];
     char* buffer = new char[1024];
-    
+
     std::cout << "Current memory usage: " << MemoryTracker::getCurrentUsage() << " bytes\n";
     std::cout << "Allocation count: " << MemoryTracker::getAllocationCount() << "\n";
-    
+
     delete[] array1;
     delete[] array2;
-    
+
     std::cout << "After deletions: " << MemoryTracker::getCurrentUsage() << " bytes\n";
-    
+
     // Generate reports
     MemoryTracker::generateReport("test_memory_report.txt");
-    
+
     // Intentionally leak buffer to test leak detection
     // delete[] buffer; // Commented out to create leak
-    
+
     MemoryTracker::generateLeakReport("test_memory_leaks.txt");
-    
+
     std::cout << "Test completed. Check test_memory_report.txt and test_memory_leaks.txt\n";
-    
+
     MemoryTracker::disable();
 }
 
 void testArenaAllocator() {
     std::cout << "\n=== Arena Allocator Test ===\n";
-    
-    #include "src/memory/arenaallocator.h"
+
     ArenaAllocator arena(1024); // 1KB arena
-    
+
     // Allocate some memory
     int* arr1 = static_cast<int*>(arena.allocate(10 * sizeof(int), alignof(int)));
     double* arr2 = static_cast<double*>(arena.allocate(5 * sizeof(double), alignof(double)));
-    
+
     // Use the memory
     for (int i = 0; i < 10; i++) arr1[i] = i * 2;
     for (int i = 0; i < 5; i++) arr2[i] = i * 1.5;
-    
+
     std::cout << "Arena total memory: " << arena.getTotalMemory() << " bytes\n";
     std::cout << "Arena used memory: " << arena.getUsedMemory() << " bytes\n";
     std::cout << "Arena wasted memory: " << arena.getWastedMemory() << " bytes\n";
-    
+
+    // Scratch inside a scope is released when it ends, even across blocks
+    size_t before = arena.getUsedMemory();
+    {
+        ArenaScope scratch(arena);
+        arena.allocate(4096);
+        std::cout << "Inside scope - used memory: " << arena.getUsedMemory() << " bytes\n";
+    }
+    std::cout << "After scope - used memory: " << arena.getUsedMemory()
+              << " bytes (" << (arena.getUsedMemory() == before ? "rewound" : "NOT rewound") << ")\n";
+
     arena.reset();
     std::cout << "After reset - used memory: " << arena.getUsedMemory() << " bytes\n";
 }
 
-int main() {
-    std::cout << "Memory Management System Test\n";
-    std::cout << "=============================\n\n";
-    
-    testMemoryTracking();
-    testArenaAllocator();
-    
-    std::cout << "\nAll tests completed!\n";
+// Nanoseconds per allocation of `size` bytes, timed over batches of
+// `batch` allocations; the arena is rewound and the pool refilled between
+// batches so every sample hits warm memory
+std::vector<double> timeArena(size_t size, AllocInit init, int batch, int samples) {
+    ArenaAllocator arena(batch * size);
+    std::vector<double> ns;
+    for (int s = -1; s < samples; ++s) {
+        ArenaScope scope(arena);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < batch; ++i)
+            arena.allocate(size, alignof(std::max_align_t), init);
+        auto end = std::chrono::steady_clock::now();
+        if (s >= 0)
+            ns.push_back(std::chrono::duration<double, std::nano>(end - start).count() / batch);
+    }
+    return ns;
+}
+
+std::vector<double> timePool(size_t size, AllocInit init, int batch, int samples) {
+    MemoryPool pool(size, 0);
+    std::vector<void*> blocks(batch);
+    std::vector<double> ns;
+    for (int s = -1; s < samples; ++s) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < batch; ++i)
+            blocks[i] = pool.allocate(size, init);
+        auto end = std::chrono::steady_clock::now();
+        for (int i = 0; i < batch; ++i)
+            pool.deallocate(blocks[i], size);
+        if (s >= 0)
+            ns.push_back(std::chrono::duration<double, std::nano>(end - start).count() / batch);
+    }
+    return ns;
+}
+
+// Cost of zero-filling in the arena and pool allocate paths, as CSV
+void benchmarkAllocInit() {
+    const int Batch = 64;
+    const int Samples = 500;
+    const AllocInit inits[] = {AllocInit::Zeroed, AllocInit::Uninitialized};
+
+    std::cout << "allocator,bytes,init,median_ns,p90_ns\n";
+    for (size_t size : {size_t(64), size_t(1024), size_t(16384)}) {
+        for (AllocInit init : inits) {
+            const char* name = init == AllocInit::Zeroed ? "zeroed" : "uninitialized";
+            TimingSummary arena = summarize(timeArena(size, init, Batch, Samples));
+            TimingSummary pool = summarize(timePool(size, init, Batch, Samples));
+            std::cout << "arena," << size << "," << name << "," << arena.median << "," << arena.p90 << "\n";
+            std::cout << "pool," << size << "," << name << "," << pool.median << "," << pool.p90 << "\n";
+        }
+    }
+#ifndef NDEBUG
+    std::cerr << "Note: debug build, uninitialized memory is pattern-filled\n";
+#endif
+}
+
+// Solver knobs parsed from the command line; each solver reads its own
+struct RunConfig {
+    bool blind = false;        // --engine blind: the baseline DFS, serial and without symmetry
+    int threads = 1;           // > 1 runs the work-stealing DFS
+    int split_depth = 3;
+    bool symmetric = true;
+    bool count_unique = false;
+    RestartPolicy policy;
+    InitStrategy init = InitStrategy::SosicGu;
+};
+
+struct RunResult {
+    double seconds = 0.0;
+    bool solved = false;
+    bool counted = false;      // `solutions` holds a full count (DFS only)
+    uint64_t solutions = 0;
+    bool countedUnique = false;  // `unique` holds the fundamental solutions (DFS --unique)
+    uint64_t unique = 0;
+    bool timedInit = false;    // `initSeconds` is the part of `seconds` spent building boards (min-conflicts)
+    double initSeconds = 0.0;
+    SearchStats stats;
+};
+
+RunResult runDfs(int n, const RunConfig& config) {
+    RunResult result;
+    SymmetryCounts counts;
+    if (config.blind) {
+        result.seconds = dfs_blind(n, counts.total, counts.stats);
+    } else if (config.threads > 1) {
+        result.seconds = dfs_parallel(n, config.threads, config.split_depth, config.symmetric,
+                                      config.count_unique, counts);
+    } else if (config.symmetric) {
+        result.seconds = dfs_symmetric(n, config.count_unique, counts);
+    } else {
+        result.seconds = dfs_bitboard(n, counts.total, counts.stats);
+    }
+    result.counted = true;
+    result.solutions = counts.total;
+    result.countedUnique = config.count_unique;
+    result.unique = counts.unique;
+    result.stats = counts.stats;
+    result.solved = counts.total > 0;
+    return result;
+}
+
+RunResult runCsp(int n, const RunConfig&) {
+    RunResult result;
+    result.seconds = dfs_csp(n, result.solved, result.stats);
+    return result;
+}
+
+RunResult runMinConflicts(int n, const RunConfig& config) {
+    RunResult result;
+    ClimbResult climb;
+    result.seconds = runHillClimbing(n, config.policy, config.init, climb);
+    result.solved = climb.solved;
+    result.timedInit = true;
+    result.initSeconds = climb.init_seconds;
+    result.stats = climb.stats;
+    return result;
+}
+
+// Counters only kept with TRACK_STATS are left empty rather than shown as 0
+void writeStat(std::ostream& out, uint64_t value) {
+    out << ",";
+    if (SearchStatsEnabled || value != 0)
+        out << value;
+}
+
+// Solver registry: --solver picks entries by name. Sizes are the sweep used
+// when neither --n nor --range is given, max_n the largest board supported.
+// CSP keeps n x n domain bits and runs O(n^2) propagation per node, so its
+// max_n is the largest board it has been seen to solve, in about 30 s.
+struct Solver {
+    const char* name;
+    RunResult (*run)(int n, const RunConfig& config);
+    std::vector<int> sizes;
+    int max_n;
+};
+
+const std::vector<Solver>& solverRegistry() {
+    static const std::vector<Solver> registry = {
+        { "dfs", runDfs, { 4, 8, 10, 12, 14, 16, 18, 20 }, 64 },
+        { "csp", runCsp, { 4, 8, 16, 32, 64, 128, 256, 512, 1024 }, 16384 },
+        { "minconflicts", runMinConflicts,
+          { 4, 8, 16, 32, 64, 128, 256, 512, 1024, 16384, 131072, 1048576 }, 1 << 24 },
+    };
+    return registry;
+}
+
+const Solver* findSolver(const std::string& name) {
+    for (const Solver& solver : solverRegistry()) {
+        if (name == solver.name)
+            return &solver;
+    }
+    return nullptr;
+}
+
+// FROM:TO[:STEP], STEP either an increment ("2") or a factor ("x2")
+bool parseRange(const char* text, std::vector<int>& sizes) {
+    int from = 0, to = 0, step = 1;
+    char kind = '+';
+    int fields = sscanf(text, "%d:%d:%d", &from, &to, &step);
+    if (fields < 3 && sscanf(text, "%d:%d:x%d", &from, &to, &step) == 3) {
+        kind = 'x';
+        fields = 3;
+    }
+    if (fields < 2 || from < 1 || to < from || step < 1 || (kind == 'x' && step < 2))
+        return false;
+    for (long long n = from; n <= to; n = kind == 'x' ? n * step : n + step)
+        sizes.push_back(static_cast<int>(n));
+    return true;
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " --solver dfs|csp|minconflicts[,...]\n"
+              << "       [--n N]... [--range FROM:TO[:STEP|:xFACTOR]]\n"
+              << "       [--warmup W] [--repeat R] [--seed S] [--threads T]\n"
+              << "       [--out summary.csv] [--raw runs.csv] [--perf]\n"
+              << "  dfs:          [--engine bitboard|blind] [--split-depth K] [--no-symmetry] [--unique]\n"
+              << "  csp:          [--max-nodes N] [--consistency fc|ac3] [--values centre|lcv]\n"
+              << "                [--arena heap|thp|hugetlb] [--numa-node K]\n"
+              << "  minconflicts: [--init random|permutation|greedy|sosic-gu]\n"
+              << "                [--max-restarts R] [--sideways S] [--tabu K]\n"
+              << "  " << program << " --memory-test runs the memory module self-test\n"
+              << "  " << program << " --alloc-bench times arena and pool allocation with and without zero-fill\n";
+}
+
+int main(int argc, char** argv) {
+    std::vector<const Solver*> selected;
+    std::vector<int> sizes;
+    int warmup = 1;
+    int repeat = 1;
+    unsigned seed = 1;
+    std::string out = "nqueens_results.csv";
+    std::string raw;
+    bool perf = false;
+    RunConfig config;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--memory-test") == 0) {
+            std::cout << "Memory Management System Test\n";
+            std::cout << "=============================\n\n";
+            testMemoryTracking();
+            testArenaAllocator();
+            std::cout << "\nAll tests completed!\n";
+            return 0;
+        } else if (strcmp(argv[i], "--alloc-bench") == 0) {
+            benchmarkAllocInit();
+            return 0;
+        } else if (strcmp(argv[i], "--solver") == 0 && hasValue) {
+            std::string list = argv[++i];
+            size_t start = 0;
+            while (start <= list.size()) {
+                size_t comma = list.find(',', start);
+                std::string name = list.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+                const Solver* solver = findSolver(name);
+                if (!solver) {
+                    std::cerr << "Unknown solver: " << name << "\n";
+                    return 1;
+                }
+                selected.push_back(solver);
+                if (comma == std::string::npos)
+                    break;
+                start = comma + 1;
+            }
+        } else if (strcmp(argv[i], "--n") == 0 && hasValue) {
+            sizes.push_back(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--range") == 0 && hasValue) {
+            if (!parseRange(argv[++i], sizes)) {
+                std::cerr << "Bad range: " << argv[i] << "\n";
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--warmup") == 0 && hasValue) {
+            warmup = std::max(0, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--repeat") == 0 && hasValue) {
+            repeat = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--threads") == 0 && hasValue) {
+            config.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+            seed = static_cast<unsigned>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--out") == 0 && hasValue) {
+            out = argv[++i];
+        } else if (strcmp(argv[i], "--raw") == 0 && hasValue) {
+            raw = argv[++i];
+        } else if (strcmp(argv[i], "--perf") == 0) {
+            perf = true;
+        } else if (strcmp(argv[i], "--engine") == 0 && hasValue) {
+            std::string engine = argv[++i];
+            if (engine == "bitboard") config.blind = false;
+            else if (engine == "blind") config.blind = true;
+            else {
+                std::cerr << "Unknown DFS engine: " << engine << "\n";
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--split-depth") == 0 && hasValue) {
+            config.split_depth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--no-symmetry") == 0) {
+            config.symmetric = false;
+        } else if (strcmp(argv[i], "--unique") == 0) {
+            config.count_unique = true;
+        } else if (strcmp(argv[i], "--max-nodes") == 0 && hasValue) {
+            cspNodeBudget = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--consistency") == 0 && hasValue) {
+            std::string level = argv[++i];
+            if (level == "fc") cspConsistency = Consistency::ForwardCheck;
+            else if (level == "ac3") cspConsistency = Consistency::AC3;
+            else {
+                std::cerr << "Unknown consistency level: " << level << "\n";
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--values") == 0 && hasValue) {
+            std::string order = argv[++i];
+            if (order == "centre") cspValueOrder = ValueOrder::Centre;
+            else if (order == "lcv") cspValueOrder = ValueOrder::LeastConstraining;
+            else {
+                std::cerr << "Unknown value order: " << order << "\n";
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--arena") == 0 && hasValue) {
+            std::string backing = argv[++i];
+            if (backing == "heap") cspArenaOptions.backing = ArenaBacking::Heap;
+            else if (backing == "thp") cspArenaOptions.backing = ArenaBacking::HugePages;
+            else if (backing == "hugetlb") cspArenaOptions.backing = ArenaBacking::HugeTLB;
+            else {
+                std::cerr << "Unknown arena backing: " << backing << "\n";
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--numa-node") == 0 && hasValue) {
+            cspArenaOptions.numaNode = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--init") == 0 && hasValue) {
+            const char* name = argv[++i];
+            if (!parseInit(name, config.init)) {
+                std::cerr << "Unknown init strategy: " << name << "\n";
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--max-restarts") == 0 && hasValue) {
+            config.policy.max_restarts = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sideways") == 0 && hasValue) {
+            config.policy.sideways_budget = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--tabu") == 0 && hasValue) {
+            config.policy.tabu_tenure = atoi(argv[++i]);
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (selected.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (config.threads <= 0)
+        config.threads = std::max(1u, std::thread::hardware_concurrency());
+    // Fundamental solutions are only counted on the symmetry-reduced tree
+    if (config.count_unique)
+        config.symmetric = true;
+    if (config.blind && (config.threads > 1 || config.count_unique)) {
+        std::cerr << "--engine blind counts every solution on one thread; "
+                  << "it takes neither --threads nor --unique\n";
+        return 1;
+    }
+
+    #ifdef TRACK_MEMORY
+    std::cout << "Memory tracking ENABLED\n";
+    MemoryTracker::startTimeline();
+    #endif
+
+    PerfCounters counters;
+    if (perf && !counters.open()) {
+        std::cerr << "Hardware counters unavailable (perf_event_open failed), "
+                  << "perf columns will be empty\n";
+    }
+
+    std::ofstream csv(out);
+    if (!csv) {
+        std::cerr << "Cannot open " << out << " for writing\n";
+        return 1;
+    }
+    std::ofstream rawCsv;
+    if (!raw.empty()) {
+        rawCsv.open(raw);
+        if (!rawCsv) {
+            std::cerr << "Cannot open " << raw << " for writing\n";
+            return 1;
+        }
+        rawCsv << "Solver,N,Run,Seed,Time(seconds),Solved,Solutions,Unique,InitTime(seconds),"
+               << "Nodes,Backtracks,Pruned,Revisions,Restarts,Moves,Sideways";
+        for (int event = 0; perf && event < PerfEventCount; ++event)
+            rawCsv << "," << PerfCounters::name(static_cast<PerfEvent>(event));
+        rawCsv << "\n";
+    }
+    // Time(seconds) is the median of the timed runs, so plots keep working
+    // off the N and Time(seconds) columns; rates are total work over total time.
+    // With --perf, per-solve counter means follow at the end of the row.
+    csv << "Solver,N,Time(seconds),Min,Median,P90,P99,Mean,Stddev,Runs,SuccessRate,"
+        << "Solutions,Unique,InitTime(seconds),Nodes/s,Steps/s";
+    if (perf) {
+        csv << ",IPC";
+        for (int event = 0; event < PerfEventCount; ++event)
+            csv << "," << PerfCounters::name(static_cast<PerfEvent>(event));
+    }
+    csv << "\n";
+    std::cout << "Seed " << seed << ", " << warmup << " warm-up and " << repeat
+              << " timed run(s) per N, " << config.threads << " thread(s)\n";
+
+    for (const Solver* solver : selected) {
+        const std::vector<int>& sweep = sizes.empty() ? solver->sizes : sizes;
+
+        std::cout << "== " << solver->name << " ==\n";
+        for (int n : sweep) {
+            if (n < 1 || n > solver->max_n) {
+                std::cerr << "Skipping N = " << n << ": " << solver->name
+                          << " supports 1 <= N <= " << solver->max_n << "\n";
+                continue;
+            }
+            #ifdef TRACK_MEMORY
+            MemoryTracker::markPhase(std::string(solver->name) + " N=" + std::to_string(n));
+            #endif
+            // Untimed runs fault in code, pools and caches for this N
+            for (int run = 0; run < warmup; ++run) {
+                srand(seed + static_cast<unsigned>(run));
+                solver->run(n, config);
+            }
+
+            std::vector<double> times;
+            int solved = 0;
+            uint64_t solutions = 0;
+            bool counted = false;
+            uint64_t unique = 0;
+            bool countedUnique = false;
+            double initTotal = 0.0;
+            bool timedInit = false;
+            SearchStats stats;
+            double total = 0.0;
+            double counts[PerfEventCount] = {};
+            int counted_runs[PerfEventCount] = {};
+            for (int run = 0; run < repeat; ++run) {
+                // Run k always replays the stream of seed + k
+                unsigned runSeed = seed + static_cast<unsigned>(run);
+                srand(runSeed);
+                if (perf)
+                    counters.start();
+                RunResult result = solver->run(n, config);
+                PerfSample sample = perf ? counters.stop() : PerfSample();
+                for (int event = 0; event < PerfEventCount; ++event) {
+                    if (sample.valid[event]) {
+                        counts[event] += sample.value[event];
+                        counted_runs[event]++;
+                    }
+                }
+                times.push_back(result.seconds);
+                total += result.seconds;
+                solved += result.solved;
+                counted = result.counted;
+                solutions = result.solutions;
+                countedUnique = result.countedUnique;
+                unique = result.unique;
+                timedInit = result.timedInit;
+                initTotal += result.initSeconds;
+                stats.merge(result.stats);
+
+                if (rawCsv.is_open()) {
+                    rawCsv << solver->name << "," << n << "," << run << "," << runSeed << ","
+                           << result.seconds << "," << result.solved << ",";
+                    if (result.counted)
+                        rawCsv << result.solutions;
+                    rawCsv << ",";
+                    if (result.countedUnique)
+                        rawCsv << result.unique;
+                    rawCsv << ",";
+                    if (result.timedInit)
+                        rawCsv << result.initSeconds;
+                    writeStat(rawCsv, result.stats.nodes);
+                    writeStat(rawCsv, result.stats.backtracks);
+                    writeStat(rawCsv, result.stats.pruned);
+                    writeStat(rawCsv, result.stats.revisions);
+                    writeStat(rawCsv, result.stats.restarts);
+                    writeStat(rawCsv, result.stats.moves);
+                    writeStat(rawCsv, result.stats.sideways);
+                    for (int event = 0; perf && event < PerfEventCount; ++event) {
+                        rawCsv << ",";
+                        if (sample.valid[event])
+                            rawCsv << sample.value[event];
+                    }
+                    rawCsv << "\n";
+                }
+            }
+
+            TimingSummary summary = summarize(times);
+            std::cout << solver->name << " N = " << n << ": median " << summary.median
+                      << " s, min " << summary.min << " s, p90 " << summary.p90
+                      << " s, stddev " << summary.stddev << " s, solved " << solved
+                      << "/" << repeat;
+            if (counted)
+                std::cout << ", " << solutions << " solutions";
+            if (countedUnique)
+                std::cout << " (" << unique << " unique)";
+            if (timedInit)
+                std::cout << ", mean init " << initTotal / repeat << " s";
+            std::cout << "\n";
+
+            csv << solver->name << "," << n << "," << summary.median << "," << summary.min << ","
+                << summary.median << "," << summary.p90 << "," << summary.p99 << ","
+                << summary.mean << "," << summary.stddev << "," << summary.runs << ","
+                << static_cast<double>(solved) / repeat << ",";
+            if (counted)
+                csv << solutions;
+            csv << ",";
+            if (countedUnique)
+                csv << unique;
+            csv << ",";
+            if (timedInit)
+                csv << initTotal / repeat;
+            csv << ",";
+            if (stats.nodes > 0 && total > 0)
+                csv << stats.nodes / total;
+            csv << ",";
+            if (stats.moves > 0 && total > 0)
+                csv << stats.moves / total;
+            if (perf) {
+                csv << ",";
+                if (counted_runs[PerfCycles] > 0 && counts[PerfCycles] > 0 && counted_runs[PerfInstructions] > 0)
+                    csv << counts[PerfInstructions] / counts[PerfCycles];
+                for (int event = 0; event < PerfEventCount; ++event) {
+                    csv << ",";
+                    if (counted_runs[event] > 0)
+                        csv << counts[event] / counted_runs[event];
+                }
+            }
+            csv << "\n";
+        }
+    }
+
+    csv.close();
+
+    #ifdef TRACK_MEMORY
+    MemoryTracker::stopTimeline();
+    MemoryTracker::exportTimelineCSV("nqueens_timeline.csv");
+    MemoryTracker::exportChromeTrace("nqueens_timeline.json");
+    MemoryTracker::generateLeakReport("nqueens_final_leaks.txt");
+    #endif
+
+    std::cout << "Results saved to " << out;
+    if (!raw.empty())
+        std::cout << ", per-run timings to " << raw;
+    std::cout << "\n";
     return 0;
-}
\ No newline at end of file
+}
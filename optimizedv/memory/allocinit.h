@@ -0,0 +1,32 @@
+#ifndef ALLOC_INIT_H
+#define ALLOC_INIT_H
+
+#include <cstddef>
+#include <cstring>
+
+// What the arena and pool write into memory before handing it out
+enum class AllocInit {
+    Uninitialized,  // nothing; the caller overwrites it (debug builds poison it)
+    Zeroed,
+    Pattern         // AllocPattern bytes, so reads of unwritten memory stand out
+};
+
+const unsigned char AllocPattern = 0xCD;
+
+inline void initializeAllocation(void* ptr, size_t size, AllocInit init) {
+    switch (init) {
+    case AllocInit::Zeroed:
+        std::memset(ptr, 0, size);
+        break;
+    case AllocInit::Pattern:
+        std::memset(ptr, AllocPattern, size);
+        break;
+    case AllocInit::Uninitialized:
+#ifndef NDEBUG
+        std::memset(ptr, AllocPattern, size);
+#endif
+        break;
+    }
+}
+
+#endif // ALLOC_INIT_H
\ No newline at end of file
@@ -1,21 +1,130 @@
 #include "arenaallocator.h"
 #include <cstdlib>
+#include <cstdint>
 #include <cstring>
 #include <iostream>
+#include <new>
 
-ArenaAllocator::ArenaAllocator(size_t initialBlockSize) 
-    : blockSize(initialBlockSize), currentBlock(0) {
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Block sizes double as the arena grows, up to this; larger requests
+    // still get a block of their own
+    const size_t MaxGrowthSize = 1 << 20;
+    
+#ifdef __linux__
+    const size_t HugePageSize = 2 << 20;
+    
+    size_t roundUp(size_t size, size_t multiple) {
+        return (size + multiple - 1) / multiple * multiple;
+    }
+    
+    // Mapping of `size` bytes aligned to `alignment`: over-map and trim the
+    // ends, so every huge page of the range can be backed by one
+    void* mapAligned(size_t size, size_t alignment) {
+        size_t length = size + alignment;
+        void* raw = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED)
+            return MAP_FAILED;
+        char* start = static_cast<char*>(raw);
+        char* aligned = reinterpret_cast<char*>(roundUp(reinterpret_cast<uintptr_t>(start), alignment));
+        if (aligned > start)
+            munmap(start, aligned - start);
+        munmap(aligned + size, start + length - (aligned + size));
+        return aligned;
+    }
+    
+    // Each fallback is reported once per process, not once per block
+    void warnOnce(bool& warned, const char* message) {
+        if (!warned)
+            std::cerr << message << "\n";
+        warned = true;
+    }
+    
+    bool hugetlbWarned = false;
+    bool mbindWarned = false;
+    
+    // Restricts the pages of [memory, memory + size) to `node`; pages are
+    // placed on first touch, so this must run before the block is used
+    void bindToNode(void* memory, size_t size, int node) {
+        const size_t bits = 8 * sizeof(unsigned long);
+        std::vector<unsigned long> mask(node / bits + 1, 0);
+        mask[node / bits] = 1UL << (node % bits);
+        if (syscall(SYS_mbind, memory, size, MPOL_BIND, mask.data(), mask.size() * bits + 1, 0) != 0)
+            warnOnce(mbindWarned, "mbind failed (no such NUMA node?), arena blocks are not bound");
+    }
+    
+    // Maps a block for the given options, rounding `size` up to what was
+    // actually mapped
+    char* mapBlock(size_t& size, const ArenaOptions& options) {
+        void* memory = MAP_FAILED;
+        if (options.backing == ArenaBacking::HugeTLB) {
+            size = roundUp(size, HugePageSize);
+            memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (memory == MAP_FAILED)
+                warnOnce(hugetlbWarned, "No hugetlb pages available (vm.nr_hugepages), "
+                                        "arena falls back to transparent huge pages");
+        }
+        if (memory == MAP_FAILED && options.backing != ArenaBacking::Heap) {
+            size = roundUp(size, HugePageSize);
+            memory = mapAligned(size, HugePageSize);
+            if (memory != MAP_FAILED)
+                madvise(memory, size, MADV_HUGEPAGE);
+        }
+        if (memory == MAP_FAILED && options.backing == ArenaBacking::Heap) {
+            size = roundUp(size, static_cast<size_t>(sysconf(_SC_PAGESIZE)));
+            memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        }
+        if (memory == MAP_FAILED)
+            throw std::bad_alloc();
+        
+        if (options.numaNode >= 0)
+            bindToNode(memory, size, options.numaNode);
+        return static_cast<char*>(memory);
+    }
+#endif
+}
+
+void ArenaBlockDeleter::operator()(char* memory) const {
+#ifdef __linux__
+    if (mapped) {
+        munmap(memory, mapped);
+        return;
+    }
+#endif
+    delete[] memory;
+}
+
+ArenaBlock::ArenaBlock(size_t size, const ArenaOptions& options) : size(size), used(0) {
+#ifdef __linux__
+    if (options.backing != ArenaBacking::Heap || options.numaNode >= 0) {
+        char* mapped = mapBlock(this->size, options);
+        memory = std::unique_ptr<char[], ArenaBlockDeleter>(mapped, ArenaBlockDeleter{this->size});
+        return;
+    }
+#endif
+    memory = std::unique_ptr<char[], ArenaBlockDeleter>(new char[size], ArenaBlockDeleter());
+}
+
+ArenaAllocator::ArenaAllocator(size_t initialBlockSize, const ArenaOptions& options) 
+    : initialBlockSize(initialBlockSize), blockSize(initialBlockSize), currentBlock(0), options(options) {
     allocateNewBlock();
 }
 
 void ArenaAllocator::allocateNewBlock(size_t minSize) {
     size_t newSize = std::max(blockSize, minSize);
-    blocks.emplace_back(newSize);
+    blocks.emplace_back(newSize, options);
     currentBlock = blocks.size() - 1;
-    blockSize = newSize * 2; // Double size for next allocation
+    blockSize = std::max(blockSize, std::min(newSize * 2, MaxGrowthSize));
 }
 
-void* ArenaAllocator::allocate(size_t size, size_t alignment) {
+void* ArenaAllocator::allocate(size_t size, size_t alignment, AllocInit init) {
     if (size == 0) return nullptr;
     
     ArenaBlock& block = blocks[currentBlock];
@@ -26,19 +135,39 @@ void* ArenaAllocator::allocate(size_t size, size_t alignment) {
     
     // Check if we have enough space
     if (offset + padding + size > block.size) {
-        allocateNewBlock(size + padding);
-        return allocate(size, alignment); // Recursive call with new block
+        // Blocks kept by reset() or rewind() are reused before the arena
+        // grows again: move to the first later one that fits
+        size_t next = currentBlock + 1;
+        while (next < blocks.size() && blocks[next].size < size + alignment)
+            next++;
+        if (next < blocks.size()) {
+            currentBlock = next;
+        } else {
+            allocateNewBlock(size + alignment);
+        }
+        return allocate(size, alignment, init); // Recursive call with the next block
     }
     
     void* ptr = block.memory.get() + offset + padding;
     block.used = offset + padding + size;
     
-    // Clear memory (optional)
-    std::memset(ptr, 0, size);
+    initializeAllocation(ptr, size, init);
     
     return ptr;
 }
 
+ArenaMarker ArenaAllocator::mark() const {
+    return ArenaMarker{currentBlock, blocks[currentBlock].used};
+}
+
+void ArenaAllocator::rewind(const ArenaMarker& marker) {
+    for (size_t i = marker.block + 1; i <= currentBlock; ++i) {
+        blocks[i].used = 0;
+    }
+    currentBlock = marker.block;
+    blocks[currentBlock].used = marker.used;
+}
+
 void ArenaAllocator::reset() {
     for (auto& block : blocks) {
         block.used = 0;
@@ -49,10 +178,17 @@ void ArenaAllocator::reset() {
 void ArenaAllocator::clear() {
     blocks.clear();
     currentBlock = 0;
-    blockSize = 65536;
+    blockSize = initialBlockSize;
     allocateNewBlock();
 }
 
+void ArenaAllocator::setOptions(const ArenaOptions& options) {
+    if (options.backing == this->options.backing && options.numaNode == this->options.numaNode)
+        return;
+    this->options = options;
+    clear();
+}
+
 size_t ArenaAllocator::getTotalMemory() const {
     size_t total = 0;
     for (const auto& block : blocks) {
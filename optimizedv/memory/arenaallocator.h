@@ -1,70 +1,146 @@
-#include "arenaallocator.h"
-#include <cstdlib>
-#include <cstring>
-#include <iostream>
-
-ArenaAllocator::ArenaAllocator(size_t initialBlockSize) 
-    : blockSize(initialBlockSize), currentBlock(0) {
-    allocateNewBlock();
-}
-
-void ArenaAllocator::allocateNewBlock(size_t minSize) {
-    size_t newSize = std::max(blockSize, minSize);
-    blocks.emplace_back(newSize);
-    currentBlock = blocks.size() - 1;
-    blockSize = newSize * 2; 
-}
-
-void* ArenaAllocator::allocate(size_t size, size_t alignment) {
-    if (size == 0) return nullptr;
-    
-    ArenaBlock& block = blocks[currentBlock];
-    size_t offset = block.used;
-    size_t padding = (alignment - (offset % alignment)) % alignment;
-    
-    if (offset + padding + size > block.size) {
-        allocateNewBlock(size + padding);
-        return allocate(size, alignment); 
-    }
-    
-    void* ptr = block.memory.get() + offset + padding;
-    block.used = offset + padding + size;
-  
-    std::memset(ptr, 0, size);
-    
-    return ptr;
-}
-
-void ArenaAllocator::reset() {
-    for (auto& block : blocks) {
-        block.used = 0;
-    }
-    currentBlock = 0;
-}
-
-void ArenaAllocator::clear() {
-    blocks.clear();
-    currentBlock = 0;
-    blockSize = 65536;
-    allocateNewBlock();
-}
-
-size_t ArenaAllocator::getTotalMemory() const {
-    size_t total = 0;
-    for (const auto& block : blocks) {
-        total += block.size;
-    }
-    return total;
-}
-
-size_t ArenaAllocator::getUsedMemory() const {
-    size_t used = 0;
-    for (const auto& block : blocks) {
-        used += block.used;
-    }
-    return used;
-}
-
-size_t ArenaAllocator::getWastedMemory() const {
-    return getTotalMemory() - getUsedMemory();
-}
+#ifndef ARENA_ALLOCATOR_H
+#define ARENA_ALLOCATOR_H
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <algorithm>
+#include "allocinit.h"
+
+// Where arena blocks come from. The mapped backings are Linux only; other
+// platforms always use the heap.
+enum class ArenaBacking {
+    Heap,       // new char[]
+    HugePages,  // 2 MiB aligned mmap with MADV_HUGEPAGE (transparent huge pages)
+    HugeTLB     // mmap from the reserved hugetlb pool, else as HugePages
+};
+
+struct ArenaOptions {
+    ArenaBacking backing = ArenaBacking::Heap;
+    int numaNode = -1;  // >= 0 binds every block to this node (heap blocks become mmap'd)
+};
+
+// Frees a block with delete[], or munmap when it was mapped
+struct ArenaBlockDeleter {
+    size_t mapped = 0;  // length of the mapping, 0 for heap blocks
+    
+    void operator()(char* memory) const;
+};
+
+struct ArenaBlock {
+    std::unique_ptr<char[], ArenaBlockDeleter> memory;
+    size_t size;  // may be rounded up to whole (huge) pages when mapped
+    size_t used;
+    
+    ArenaBlock(size_t size, const ArenaOptions& options);
+};
+
+// Position in an arena, taken by mark(); rewind() gives back everything
+// allocated after it
+struct ArenaMarker {
+    size_t block;
+    size_t used;
+};
+
+// Bump allocator: memory is handed out from large blocks and given back in
+// stack order by rewind(), or all at once by reset() or clear(). Blocks past
+// currentBlock are always empty, ready to be reused.
+class ArenaAllocator {
+private:
+    size_t initialBlockSize;
+    size_t blockSize;  // of the next block; doubles as the arena grows
+    std::vector<ArenaBlock> blocks;
+    size_t currentBlock;
+    ArenaOptions options;
+    
+    void allocateNewBlock(size_t minSize = 0);
+    
+public:
+    ArenaAllocator(size_t initialBlockSize = 65536, const ArenaOptions& options = ArenaOptions());
+    ~ArenaAllocator() = default;
+    
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t),
+                   AllocInit init = AllocInit::Zeroed);
+    
+    ArenaMarker mark() const;
+    // Frees everything allocated since `marker`; later markers become invalid
+    void rewind(const ArenaMarker& marker);
+    
+    // Rewinds every block; the memory stays owned by the arena
+    void reset();
+    // Frees every block and starts over with a single one of the initial size
+    void clear();
+    
+    // Backing for the blocks from now on; the arena is cleared unless the
+    // options are unchanged
+    void setOptions(const ArenaOptions& options);
+    const ArenaOptions& getOptions() const { return options; }
+    
+    size_t getTotalMemory() const;
+    size_t getUsedMemory() const;
+    size_t getWastedMemory() const;
+    
+    // Disable copying
+    ArenaAllocator(const ArenaAllocator&) = delete;
+    ArenaAllocator& operator=(const ArenaAllocator&) = delete;
+    
+    // Allow moving
+    ArenaAllocator(ArenaAllocator&&) = default;
+    ArenaAllocator& operator=(ArenaAllocator&&) = default;
+};
+
+// STL allocator drawing from an ArenaAllocator; deallocate() is a no-op and
+// the memory comes back when the arena is reset or rewound. Containers
+// construct their elements, so the memory is handed out uninitialized.
+template<typename T>
+class ArenaAllocatorWrapper {
+private:
+    ArenaAllocator* arena;
+    
+    template<typename U> friend class ArenaAllocatorWrapper;
+    
+public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_swap = std::false_type;
+    using is_always_equal = std::false_type;
+    
+    ArenaAllocatorWrapper(ArenaAllocator& arena) noexcept : arena(&arena) {}
+    
+    template<typename U>
+    ArenaAllocatorWrapper(const ArenaAllocatorWrapper<U>& other) noexcept : arena(other.arena) {}
+    
+    T* allocate(size_t n) {
+        return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T), AllocInit::Uninitialized));
+    }
+    
+    void deallocate(T*, size_t) noexcept {}
+    
+    template<typename U>
+    bool operator==(const ArenaAllocatorWrapper<U>& other) const noexcept {
+        return arena == other.arena;
+    }
+    
+    template<typename U>
+    bool operator!=(const ArenaAllocatorWrapper<U>& other) const noexcept {
+        return !(*this == other);
+    }
+};
+
+// Marks the arena on construction and rewinds it on destruction, so the
+// scratch a scope allocates is released when it ends
+class ArenaScope {
+private:
+    ArenaAllocator& arena;
+    ArenaMarker marker;
+    
+public:
+    explicit ArenaScope(ArenaAllocator& arena) : arena(arena), marker(arena.mark()) {}
+    ~ArenaScope() { arena.rewind(marker); }
+    
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+};
+
+#endif // ARENA_ALLOCATOR_H
@@ -0,0 +1,113 @@
+#include "memorytracker.h"
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Replacements for every global new/delete, so containers and other
+// library allocations are tracked too. Only nqueens_tracked links this
+// file; other builds keep the standard library's operators. Aligned blocks
+// come from posix_memalign, which free() releases, so one trackFree()
+// serves all. Each allocation records the operator's return address,
+// which reports resolve to the function that allocated.
+#ifdef TRACK_MEMORY
+
+namespace {
+    void* allocate(size_t size, size_t alignment, const char* what, void* caller) {
+        if (size == 0) size = 1;
+        if (alignment > alignof(std::max_align_t))
+            return MemoryTracker::trackAlignedAlloc(size, alignment, what, 0, caller);
+        return MemoryTracker::trackAlloc(size, what, 0, caller);
+    }
+    
+    void* allocateOrThrow(size_t size, size_t alignment, const char* what, void* caller) {
+        for (;;) {
+            void* ptr = allocate(size, alignment, what, caller);
+            if (ptr) return ptr;
+            std::new_handler handler = std::get_new_handler();
+            if (!handler) throw std::bad_alloc();
+            handler();
+        }
+    }
+}
+
+void* operator new(size_t size) {
+    return allocateOrThrow(size, 0, "operator new", __builtin_return_address(0));
+}
+
+void* operator new[](size_t size) {
+    return allocateOrThrow(size, 0, "operator new[]", __builtin_return_address(0));
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    return allocateOrThrow(size, static_cast<size_t>(alignment), "operator new", __builtin_return_address(0));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    return allocateOrThrow(size, static_cast<size_t>(alignment), "operator new[]", __builtin_return_address(0));
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size, 0, "operator new", __builtin_return_address(0));
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size, 0, "operator new[]", __builtin_return_address(0));
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, static_cast<size_t>(alignment), "operator new", __builtin_return_address(0));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, static_cast<size_t>(alignment), "operator new[]", __builtin_return_address(0));
+}
+
+void operator delete(void* ptr) noexcept {
+    MemoryTracker::trackFree(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    MemoryTracker::trackFree(ptr);
+}
+
+void operator delete(void* ptr, size_t size) noexcept {
+    MemoryTracker::trackFree(ptr);
+}
+
+void operator delete[](void* ptr, size_t size) noexcept {
+    MemoryTracker::trackFree(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    MemoryTracker::trackFree(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    MemoryTracker::trackFree(ptr);
+}
+
+void operator delete(void* ptr, size_t size, std::align_val_t) noexcept {
+    MemoryTracker::trackFree(ptr);
+}
+
+void operator delete[](void* ptr, size_t size, std::align_val_t) noexcept {
+    MemoryTracker::trackFree(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    MemoryTracker::trackFree(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    MemoryTracker::trackFree(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    MemoryTracker::trackFree(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    MemoryTracker::trackFree(ptr);
+}
+
+#endif // TRACK_MEMORY
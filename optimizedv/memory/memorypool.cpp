@@ -1,47 +1,232 @@
 #include "memorypool.h"
 #include <cstdlib>
 #include <cstring>
-#include <iostream>
+#include <algorithm>
+#include <unordered_set>
 
-MemoryPool::MemoryPool(size_t blockSize, size_t initialBlocks)
-    : blockSize(std::max(blockSize, sizeof(Block))), poolSize(initialBlocks), freeList(nullptr) {
-    allocatePool();
+namespace {
+    // Every live pool, by serial; thread caches only hand blocks back to
+    // pools still in this set. Never destroyed, so threads exiting during
+    // static destruction can still consult it.
+    std::mutex& liveMutex() {
+        static std::mutex* mutex = new std::mutex();
+        return *mutex;
+    }
+    
+    std::unordered_set<uint64_t>& livePools() {
+        static std::unordered_set<uint64_t>* pools = new std::unordered_set<uint64_t>();
+        return *pools;
+    }
+    
+    std::atomic<uint64_t> nextSerial(1);
+    
+    // Blocks carved per refill of an empty class
+    const size_t ChunkBytes = 64 * 1024;
+    
+    const uint64_t PointerMask = (uint64_t(1) << 48) - 1;
 }
 
-void MemoryPool::allocatePool() {
-    // Allocate new pool
-    auto pool = std::make_unique<char[]>(blockSize * poolSize);
+// Per-thread free lists, one set per pool the thread has used. Counts are
+// a flush heuristic: a batch from the depot is assumed full, and an empty
+// list resets its count.
+struct PoolCaches {
+    struct Entry {
+        MemoryPool* pool;
+        uint64_t serial;
+        MemoryPool::Block* lists[MemoryPool::ClassCount];
+        uint32_t counts[MemoryPool::ClassCount];
+    };
+    
+    std::vector<Entry> entries;
+    size_t last = 0;
     
-    // Add all blocks to free list
-    char* start = pool.get();
-    for (size_t i = 0; i < poolSize; ++i) {
-        Block* block = reinterpret_cast<Block*>(start + i * blockSize);
-        block->next = freeList;
-        freeList = block;
+    Entry& forPool(MemoryPool& pool) {
+        if (last < entries.size() && entries[last].pool == &pool && entries[last].serial == pool.serial)
+            return entries[last];
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (entries[i].pool == &pool && entries[i].serial == pool.serial) {
+                last = i;
+                return entries[i];
+            }
+        }
+        
+        // First use of this pool on this thread; drop caches of dead pools
+        {
+            std::lock_guard<std::mutex> lock(liveMutex());
+            entries.erase(std::remove_if(entries.begin(), entries.end(), [](const Entry& entry) {
+                return livePools().count(entry.serial) == 0;
+            }), entries.end());
+        }
+        Entry entry = {};
+        entry.pool = &pool;
+        entry.serial = pool.serial;
+        entries.push_back(entry);
+        last = entries.size() - 1;
+        return entries[last];
+    }
+    
+    // Return everything to the depots of the pools that are still alive
+    ~PoolCaches() {
+        std::lock_guard<std::mutex> lock(liveMutex());
+        for (Entry& entry : entries) {
+            if (livePools().count(entry.serial) == 0)
+                continue;
+            for (int c = 0; c < MemoryPool::ClassCount; ++c) {
+                if (entry.lists[c])
+                    entry.pool->pushBatch(c, entry.lists[c]);
+            }
+        }
+    }
+};
+
+namespace {
+    thread_local PoolCaches caches;
+}
+
+int MemoryPool::sizeClass(size_t size) {
+    if (size <= MinBlock) return 0;
+    return 64 - __builtin_clzll(static_cast<unsigned long long>(size - 1)) - 4;
+}
+
+MemoryPool::MemoryPool(size_t blockSize, size_t initialBlocks)
+    : blockSize(std::max<size_t>(blockSize, 1)), serial(nextSerial++) {
+    {
+        std::lock_guard<std::mutex> lock(liveMutex());
+        livePools().insert(serial);
     }
     
-    // Store pool ownership
-    pools.push_back(std::move(pool));
+    // Pre-carve the constructor's block size into full depot batches
+    if (this->blockSize <= MaxBlock && initialBlocks > 0) {
+        int c = sizeClass(this->blockSize);
+        size_t batches = (initialBlocks + BatchBlocks - 1) / BatchBlocks;
+        Block* block = carve(c, batches * BatchBlocks);
+        for (size_t b = 0; b < batches; ++b) {
+            Block* batch = block;
+            for (uint32_t i = 1; i < BatchBlocks; ++i)
+                block = block->next;
+            Block* rest = block->next;
+            block->next = nullptr;
+            pushBatch(c, batch);
+            block = rest;
+        }
+    }
+}
+
+MemoryPool::~MemoryPool() {
+    std::lock_guard<std::mutex> lock(liveMutex());
+    livePools().erase(serial);
+}
+
+void MemoryPool::pushBatch(int sizeClass, Block* batch) {
+    std::atomic<uint64_t>& head = depots[sizeClass].head;
+    uint64_t old = head.load(std::memory_order_relaxed);
+    uint64_t next;
+    do {
+        batch->nextBatch = reinterpret_cast<Block*>(old & PointerMask);
+        next = reinterpret_cast<uint64_t>(batch) | ((old & ~PointerMask) + (PointerMask + 1));
+    } while (!head.compare_exchange_weak(old, next, std::memory_order_release, std::memory_order_relaxed));
+}
+
+// top->nextBatch of a batch another thread may have popped and reused in
+// the meantime: that read races with the new owner's writes, and the tag
+// then discards it. Kept out of line so only this load escapes
+// ThreadSanitizer, not the CAS that orders the pop.
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((no_sanitize("thread"), noinline))
+#endif
+MemoryPool::Block* MemoryPool::racyNextBatch(const Block* top) {
+    return top->nextBatch;
+}
+
+MemoryPool::Block* MemoryPool::popBatch(int sizeClass) {
+    std::atomic<uint64_t>& head = depots[sizeClass].head;
+    uint64_t old = head.load(std::memory_order_acquire);
+    for (;;) {
+        Block* top = reinterpret_cast<Block*>(old & PointerMask);
+        if (!top)
+            return nullptr;
+        // top may already be popped and reused; the tag then fails the CAS.
+        // Chunks are only freed with the pool, so the read itself is safe.
+        uint64_t next = reinterpret_cast<uint64_t>(racyNextBatch(top)) | ((old & ~PointerMask) + (PointerMask + 1));
+        if (head.compare_exchange_weak(old, next, std::memory_order_acquire, std::memory_order_acquire))
+            return top;
+    }
+}
+
+// Cut a fresh chunk into a linked list of `blocks` blocks
+MemoryPool::Block* MemoryPool::carve(int sizeClass, size_t blocks) {
+    size_t size = classSize(sizeClass);
+    auto chunk = std::make_unique<char[]>(size * blocks);
+    char* start = chunk.get();
+    for (size_t i = 0; i < blocks; ++i) {
+        Block* block = reinterpret_cast<Block*>(start + i * size);
+        block->next = i + 1 < blocks ? reinterpret_cast<Block*>(start + (i + 1) * size) : nullptr;
+    }
+    
+    std::lock_guard<std::mutex> lock(chunkMutex);
+    chunks.push_back(std::move(chunk));
+    return reinterpret_cast<Block*>(start);
+}
+
+MemoryPool::Block* MemoryPool::refill(int sizeClass, uint32_t& blocks) {
+    Block* batch = popBatch(sizeClass);
+    if (batch) {
+        blocks = BatchBlocks;
+        return batch;
+    }
+    blocks = static_cast<uint32_t>(std::max<size_t>(ChunkBytes / classSize(sizeClass), 1));
+    return carve(sizeClass, blocks);
 }
 
 void* MemoryPool::allocate() {
-    if (!freeList) {
-        allocatePool();
+    return allocate(blockSize);
+}
+
+void MemoryPool::deallocate(void* ptr) {
+    deallocate(ptr, blockSize);
+}
+
+void* MemoryPool::allocate(size_t size, AllocInit init) {
+    if (size > MaxBlock) {
+        void* ptr = ::operator new(size);
+        initializeAllocation(ptr, size, init);
+        return ptr;
     }
     
-    Block* block = freeList;
-    freeList = freeList->next;
+    int c = sizeClass(size);
+    PoolCaches::Entry& cache = caches.forPool(*this);
+    Block* block = cache.lists[c];
+    if (!block)
+        block = refill(c, cache.counts[c]);
+    cache.lists[c] = block->next;
+    cache.counts[c] = block->next && cache.counts[c] > 0 ? cache.counts[c] - 1 : 0;
     
-    // Clear memory (optional, but good practice)
-    std::memset(block, 0, blockSize);
+    initializeAllocation(block, size, init);
     
     return block;
 }
 
-void MemoryPool::deallocate(void* ptr) {
+void MemoryPool::deallocate(void* ptr, size_t size) {
     if (!ptr) return;
+    if (size > MaxBlock) {
+        ::operator delete(ptr);
+        return;
+    }
     
+    int c = sizeClass(size);
+    PoolCaches::Entry& cache = caches.forPool(*this);
     Block* block = static_cast<Block*>(ptr);
-    block->next = freeList;
-    freeList = block;
+    block->next = cache.lists[c];
+    cache.lists[c] = block;
+    
+    // Keep one batch locally and hand the next one to the depot
+    if (++cache.counts[c] >= 2 * BatchBlocks) {
+        Block* tail = block;
+        for (uint32_t i = 1; i < BatchBlocks && tail->next; ++i)
+            tail = tail->next;
+        cache.lists[c] = tail->next;
+        tail->next = nullptr;
+        pushBatch(c, block);
+        cache.counts[c] -= BatchBlocks;
+    }
 }
\ No newline at end of file
@@ -3,73 +3,104 @@
 
 #include <vector>
 #include <memory>
+#include <mutex>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <new>
+#include "allocinit.h"
 
+// Thread-safe pool of power-of-two size classes (16 bytes to 64 KiB).
+// Each thread keeps a small free list per class; full and empty lists are
+// exchanged in batches with a lock-free depot shared by all threads, so the
+// common allocate/deallocate touches no shared cache line. Requests above
+// the largest class go to ::operator new.
 class MemoryPool {
+public:
+    static constexpr int ClassCount = 13;
+    static constexpr size_t MinBlock = 16;
+    static constexpr size_t MaxBlock = MinBlock << (ClassCount - 1);
+    static constexpr uint32_t BatchBlocks = 32;  // blocks moved per depot exchange
+    
 private:
     struct Block {
-        Block* next;
+        Block* next;       // next block of the same batch
+        Block* nextBatch;  // next batch in the depot (first block only)
+    };
+    
+    // Treiber stack of batches; the top 16 bits of head carry an ABA tag
+    struct alignas(64) Depot {
+        std::atomic<uint64_t> head{0};
     };
     
     size_t blockSize;
-    size_t poolSize;
-    std::vector<std::unique_ptr<char[]>> pools;
-    Block* freeList;
+    uint64_t serial;
+    Depot depots[ClassCount];
+    std::mutex chunkMutex;
+    std::vector<std::unique_ptr<char[]>> chunks;
+    
+    static int sizeClass(size_t size);
+    static size_t classSize(int sizeClass) { return MinBlock << sizeClass; }
     
-    void allocatePool();
+    void pushBatch(int sizeClass, Block* batch);
+    static Block* racyNextBatch(const Block* top);
+    Block* popBatch(int sizeClass);
+    Block* carve(int sizeClass, size_t blocks);
+    Block* refill(int sizeClass, uint32_t& blocks);
+    
+    friend struct PoolCaches;
     
 public:
     MemoryPool(size_t blockSize, size_t initialBlocks = 1024);
-    ~MemoryPool() = default;
+    ~MemoryPool();
     
+    // Zeroed blocks of the size given to the constructor
     void* allocate();
     void deallocate(void* ptr);
     
-    // Disable copying
+    // Any size; deallocate must be passed the size given to allocate
+    void* allocate(size_t size, AllocInit init = AllocInit::Zeroed);
+    void deallocate(void* ptr, size_t size);
+    
+    // Disable copying and moving: thread caches refer to the pool by address
     MemoryPool(const MemoryPool&) = delete;
     MemoryPool& operator=(const MemoryPool&) = delete;
-    
-    // Allow moving
-    MemoryPool(MemoryPool&&) = default;
-    MemoryPool& operator=(MemoryPool&&) = default;
 };
 
 template<typename T>
 class MemoryPoolAllocator {
 private:
-    MemoryPool& pool;
+    MemoryPool* pool;
+    
+    template<typename U> friend class MemoryPoolAllocator;
     
 public:
     using value_type = T;
     using propagate_on_container_move_assignment = std::true_type;
-    using propagate_on_container_copy_assignment = std::false_type;
-    using propagate_on_container_swap = std::false_type;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
     using is_always_equal = std::false_type;
     
-    MemoryPoolAllocator(MemoryPool& pool) noexcept : pool(pool) {}
+    static_assert(alignof(T) <= alignof(std::max_align_t), "MemoryPool blocks are max_align_t aligned");
+    
+    MemoryPoolAllocator(MemoryPool& pool) noexcept : pool(&pool) {}
     
     template<typename U>
     MemoryPoolAllocator(const MemoryPoolAllocator<U>& other) noexcept : pool(other.pool) {}
     
+    // Arrays (every vector buffer) come from the size class of n * sizeof(T),
+    // uninitialized since the container constructs the elements
     T* allocate(size_t n) {
-        if (n != 1) {
-            // For arrays, fall back to new
-            return static_cast<T*>(::operator new(n * sizeof(T)));
-        }
-        return static_cast<T*>(pool.allocate());
+        return static_cast<T*>(pool->allocate(n * sizeof(T), AllocInit::Uninitialized));
     }
     
     void deallocate(T* ptr, size_t n) {
-        if (n != 1) {
-            ::operator delete(ptr);
-        } else {
-            pool.deallocate(ptr);
-        }
+        pool->deallocate(ptr, n * sizeof(T));
     }
     
     template<typename U>
     bool operator==(const MemoryPoolAllocator<U>& other) const noexcept {
-        return &pool == &other.pool;
+        return pool == other.pool;
     }
     
     template<typename U>
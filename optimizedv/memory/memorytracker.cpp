@@ -1,4 +1,8 @@
 #include "memorytracker.h"
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <unordered_map>
 #include <iostream>
 #include <sstream>
 #include <iomanip>
@@ -6,35 +10,301 @@
 #include <cstdlib>
 #include <cstring>
 #include <algorithm>
+#include <new>
 
 #ifdef __linux__
 #include <execinfo.h>
+#include <cxxabi.h>
 #endif
 
 // Initialize static members
-std::unordered_map<void*, AllocationInfo> MemoryTracker::allocations;
-std::mutex MemoryTracker::mutex;
-std::atomic<uint64_t> MemoryTracker::totalAllocated(0);
-std::atomic<uint64_t> MemoryTracker::totalFreed(0);
-std::atomic<uint64_t> MemoryTracker::peakUsage(0);
-std::atomic<uint64_t> MemoryTracker::currentUsage(0);
-std::atomic<uint64_t> MemoryTracker::allocationCount(0);
+std::atomic<bool> MemoryTracker::enabled(false);
+std::atomic<uint32_t> MemoryTracker::sampleEvery(1024);
+std::atomic<size_t> MemoryTracker::sampleMinSize(1 << 20);
 std::atomic<uint64_t> MemoryTracker::fragmentation(0);
-bool MemoryTracker::enabled = false;
 
-std::string MemoryTracker::getStackTrace(int maxDepth) {
-    std::stringstream ss;
+namespace {
+    // Per-thread counters. Only the owning thread writes them (plain
+    // load + store, no locked instructions); readers sum every slot.
+    struct ThreadCounters {
+        std::atomic<uint64_t> allocated{0};
+        std::atomic<uint64_t> freed{0};
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> frees{0};
+        std::atomic<int64_t> pending{0};  // net bytes not yet added to publishedUsage
+        std::atomic<uint64_t> classCount[MemoryTracker::SizeClassCount] = {};
+        std::atomic<uint64_t> classBytes[MemoryTracker::SizeClassCount] = {};
+        ThreadCounters* next = nullptr;
+    };
+    
+    // Pending bytes a thread may hold back before publishing them, which
+    // bounds how far the peak can lag behind
+    const int64_t PublishBytes = 64 * 1024;
+    
+    std::mutex registryMutex;
+    ThreadCounters* registry = nullptr;
+    // Counts of threads that have exited
+    std::atomic<uint64_t> retiredAllocated(0);
+    std::atomic<uint64_t> retiredFreed(0);
+    std::atomic<uint64_t> retiredCount(0);
+    std::atomic<uint64_t> retiredFrees(0);
+    std::atomic<uint64_t> retiredClassCount[MemoryTracker::SizeClassCount];
+    std::atomic<uint64_t> retiredClassBytes[MemoryTracker::SizeClassCount];
+    
+    std::atomic<int64_t> publishedUsage(0);
+    std::mutex logMutex;
+    std::atomic<uint64_t> peakUsage(0);
+    std::atomic<uint64_t> windowPeak(0);  // peak since the last timeline sample
+    
+    inline void bump(std::atomic<uint64_t>& counter, uint64_t amount) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+    
+    inline void raise(std::atomic<uint64_t>& peak, uint64_t value) {
+        uint64_t seen = peak.load(std::memory_order_relaxed);
+        while (value > seen && !peak.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+        }
+    }
+    
+    // Adds `pending`, the thread's unpublished bytes, to publishedUsage and
+    // raises the peaks to the usage that results
+    void flush(ThreadCounters& local, int64_t pending) {
+        local.pending.store(0, std::memory_order_relaxed);
+        int64_t usage = publishedUsage.fetch_add(pending, std::memory_order_relaxed) + pending;
+        if (usage > 0) {
+            raise(peakUsage, usage);
+            raise(windowPeak, usage);
+        }
+    }
+    
+    void publish(ThreadCounters& local, int64_t delta) {
+        int64_t pending = local.pending.load(std::memory_order_relaxed) + delta;
+        if (pending < PublishBytes && pending > -PublishBytes) {
+            local.pending.store(pending, std::memory_order_relaxed);
+            return;
+        }
+        flush(local, pending);
+    }
+    
+    // Set once the thread's LocalSlot is gone; frees made later by other
+    // thread_local destructors go straight to the retired totals
+    thread_local bool slotRetired = false;
+    
+    // Registers the thread's counters on first use and folds them into the
+    // retired totals when the thread exits
+    struct LocalSlot {
+        ThreadCounters* counters;
+        
+        LocalSlot() : counters(new ThreadCounters()) {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            counters->next = registry;
+            registry = counters;
+        }
+        
+        ~LocalSlot() {
+            flush(*counters, counters->pending.load(std::memory_order_relaxed));
+            std::lock_guard<std::mutex> lock(registryMutex);
+            retiredAllocated += counters->allocated.load();
+            retiredFreed += counters->freed.load();
+            retiredCount += counters->count.load();
+            retiredFrees += counters->frees.load();
+            for (int c = 0; c < MemoryTracker::SizeClassCount; c++) {
+                retiredClassCount[c] += counters->classCount[c].load();
+                retiredClassBytes[c] += counters->classBytes[c].load();
+            }
+            for (ThreadCounters** link = &registry; *link; link = &(*link)->next) {
+                if (*link == counters) {
+                    *link = counters->next;
+                    break;
+                }
+            }
+            delete counters;
+            slotRetired = true;
+        }
+    };
+    
+    ThreadCounters& localCounters() {
+        thread_local LocalSlot slot;
+        return *slot.counters;
+    }
+    
+    // Set while the tracker itself runs, so allocations made for its own
+    // tables are never tracked (or tracked recursively)
+    thread_local bool inTracker = false;
+    
+    // Scopes nest: reports call getters that open their own
+    struct TrackerScope {
+        bool outer;
+        TrackerScope() : outer(inTracker) { inTracker = true; }
+        ~TrackerScope() { inTracker = outer; }
+    };
+    
+    inline uint64_t hashPointer(void* ptr) {
+        return (reinterpret_cast<uintptr_t>(ptr) >> 4) * 0x9E3779B97F4A7C15ULL;
+    }
+    
+    // Open-addressing table of live allocations (linear probing, backward
+    // shift on erase), so tracking an allocation never allocates a node.
+    // The top 6 hash bits pick the shard; the slot comes from the next ones.
+    class AllocationTable {
+    public:
+        struct Slot {
+            void* ptr = nullptr;
+            size_t size = 0;
+            const char* file = nullptr;
+            int line = 0;
+            void* caller = nullptr;
+            bool sampled = false;
+            uint64_t timestamp = 0;
+        };
+        
+        bool put(const AllocationInfo& info) {
+            if ((used + 1) * 2 > slots.size())
+                grow();
+            size_t i = find(info.ptr);
+            bool fresh = slots[i].ptr == nullptr;
+            slots[i].ptr = info.ptr;
+            slots[i].size = info.size;
+            slots[i].file = info.file;
+            slots[i].line = info.line;
+            slots[i].caller = info.caller;
+            slots[i].timestamp = info.timestamp;
+            slots[i].sampled = !info.stack.empty();
+            if (fresh) used++;
+            return fresh;
+        }
+        
+        // Removes ptr, reporting its size and whether a stack was sampled
+        bool take(void* ptr, size_t& size, bool& sampled) {
+            if (slots.empty()) return false;
+            size_t i = find(ptr);
+            if (slots[i].ptr == nullptr) return false;
+            size = slots[i].size;
+            sampled = slots[i].sampled;
+            
+            size_t mask = slots.size() - 1;
+            for (size_t j = (i + 1) & mask; slots[j].ptr; j = (j + 1) & mask) {
+                size_t home = homeSlot(slots[j].ptr);
+                // Shift j back into the hole unless its home lies in (i, j]
+                bool stays = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+                if (!stays) {
+                    slots[i] = slots[j];
+                    i = j;
+                }
+            }
+            slots[i].ptr = nullptr;
+            used--;
+            return true;
+        }
+        
+        void clear() {
+            std::vector<Slot>().swap(slots);
+            used = 0;
+            bits = 0;
+        }
+        
+        size_t size() const { return used; }
+        
+        template<typename Fn>
+        void forEach(Fn fn) const {
+            for (const Slot& slot : slots)
+                if (slot.ptr) fn(slot);
+        }
+        
+    private:
+        std::vector<Slot> slots;  // power-of-two size, at most half full
+        size_t used = 0;
+        int bits = 0;
+        
+        size_t homeSlot(void* ptr) const {
+            return (hashPointer(ptr) << 6) >> (64 - bits);
+        }
+        
+        size_t find(void* ptr) const {
+            size_t mask = slots.size() - 1;
+            size_t i = homeSlot(ptr);
+            while (slots[i].ptr && slots[i].ptr != ptr)
+                i = (i + 1) & mask;
+            return i;
+        }
+        
+        void grow() {
+            std::vector<Slot> old;
+            old.swap(slots);
+            bits = bits ? bits + 1 : 8;
+            slots.resize(size_t(1) << bits);
+            for (const Slot& slot : old) {
+                if (slot.ptr)
+                    slots[find(slot.ptr)] = slot;
+            }
+        }
+    };
+    
+    // Live allocations, sharded by address so threads rarely share a lock.
+    // Sampled stacks are rare enough to keep in an ordinary map.
+    const size_t ShardCount = 64;
+    
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        AllocationTable allocations;
+        std::unordered_map<void*, std::vector<void*>> stacks;
+    };
     
+    // Created on first use and never destroyed, so allocations made before
+    // main() or freed during static destruction still find their shard
+    Shard* shardTable() {
+        static Shard* shards = new Shard[ShardCount];
+        return shards;
+    }
+    
+    Shard& shardFor(void* ptr) {
+        return shardTable()[hashPointer(ptr) >> 58];
+    }
+    
+    // Calls fn(info) for every live allocation, one shard at a time
+    template<typename Fn>
+    void forEachAllocation(Fn fn) {
+        for (size_t i = 0; i < ShardCount; i++) {
+            Shard& shard = shardTable()[i];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.allocations.forEach([&](const AllocationTable::Slot& slot) {
+                AllocationInfo info{slot.ptr, slot.size, slot.file, slot.line, slot.caller, slot.timestamp, {}};
+                auto stack = shard.stacks.find(slot.ptr);
+                if (stack != shard.stacks.end())
+                    info.stack = stack->second;
+                fn(info);
+            });
+        }
+    }
+    
+    template<typename Field>
+    uint64_t sumCounters(Field field, const std::atomic<uint64_t>& retired) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        uint64_t total = retired.load();
+        for (ThreadCounters* counters = registry; counters; counters = counters->next)
+            total += (counters->*field).load(std::memory_order_relaxed);
+        return total;
+    }
+}
+
+void MemoryTracker::captureStack(std::vector<void*>& stack, int maxDepth) {
 #ifdef __linux__
-    void* array[maxDepth];
-    char** strings;
-    int size;
+    stack.resize(maxDepth);
+    int size = backtrace(stack.data(), maxDepth);
+    stack.resize(size);
+#endif
+}
+
+std::string MemoryTracker::formatStack(const std::vector<void*>& stack) {
+    std::stringstream ss;
     
-    size = backtrace(array, maxDepth);
-    strings = backtrace_symbols(array, size);
+#ifdef __linux__
+    if (stack.empty())
+        return "Stack trace not sampled\n";
     
+    char** strings = backtrace_symbols(stack.data(), stack.size());
     if (strings != nullptr) {
-        for (int i = 1; i < size; i++) { // Skip first (this function)
+        for (size_t i = 2; i < stack.size(); i++) { // Skip the tracker's own frames
             ss << strings[i] << "\n";
         }
         free(strings);
@@ -46,6 +316,38 @@ std::string MemoryTracker::getStackTrace(int maxDepth) {
     return ss.str();
 }
 
+std::string MemoryTracker::formatSite(const AllocationInfo& info) {
+    if (!info.caller)
+        return std::string(info.file) + ":" + std::to_string(info.line);
+    
+    std::string site = std::string(info.file) + " from ";
+#ifdef __linux__
+    // "binary(mangled+0x1f) [address]": keep the demangled function and
+    // offset when the symbol is exported, else the whole line
+    char** strings = backtrace_symbols(const_cast<void**>(&info.caller), 1);
+    if (strings != nullptr) {
+        std::string line = strings[0];
+        free(strings);
+        size_t open = line.find('(');
+        size_t plus = line.find('+', open);
+        if (open != std::string::npos && plus != std::string::npos && plus > open + 1) {
+            std::string name = line.substr(open + 1, plus - open - 1);
+            int status = 0;
+            char* demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+            if (status == 0 && demangled) {
+                name = demangled;
+                free(demangled);
+            }
+            return site + name + line.substr(plus, line.find(')', plus) - plus);
+        }
+        return site + line;
+    }
+#endif
+    std::stringstream ss;
+    ss << info.caller;
+    return site + ss.str();
+}
+
 void MemoryTracker::enable() {
     enabled = true;
 }
@@ -55,80 +357,201 @@ void MemoryTracker::disable() {
 }
 
 void MemoryTracker::reset() {
-    std::lock_guard<std::mutex> lock(mutex);
-    allocations.clear();
-    totalAllocated = 0;
-    totalFreed = 0;
+    TrackerScope scope;
+    for (size_t i = 0; i < ShardCount; i++) {
+        Shard& shard = shardTable()[i];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.allocations.clear();
+        shard.stacks.clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (ThreadCounters* counters = registry; counters; counters = counters->next) {
+            counters->allocated = 0;
+            counters->freed = 0;
+            counters->count = 0;
+            counters->frees = 0;
+            counters->pending = 0;
+            for (int c = 0; c < SizeClassCount; c++) {
+                counters->classCount[c] = 0;
+                counters->classBytes[c] = 0;
+            }
+        }
+        retiredAllocated = 0;
+        retiredFreed = 0;
+        retiredCount = 0;
+        retiredFrees = 0;
+        for (int c = 0; c < SizeClassCount; c++) {
+            retiredClassCount[c] = 0;
+            retiredClassBytes[c] = 0;
+        }
+    }
+    publishedUsage = 0;
     peakUsage = 0;
-    currentUsage = 0;
-    allocationCount = 0;
+    windowPeak = 0;
     fragmentation = 0;
 }
 
-void* MemoryTracker::trackAlloc(size_t size, const char* file, int line) {
-    if (!enabled) {
-        return malloc(size);
-    }
-    
-    void* ptr = malloc(size);
-    if (!ptr) {
+void MemoryTracker::setStackSampling(uint32_t everyN, size_t minSize) {
+    sampleEvery = everyN;
+    sampleMinSize = minSize;
+}
+
+int MemoryTracker::sizeClass(size_t size) {
+    if (size <= 16) return 0;
+    int bits = 64 - __builtin_clzll(static_cast<unsigned long long>(size - 1));
+    return std::min(bits - 4, SizeClassCount - 1);
+}
+
+void* MemoryTracker::trackAlloc(size_t size, const char* file, int line, void* caller) {
+    return recordAlloc(malloc(size), size, file, line, caller);
+}
+
+void* MemoryTracker::trackAlignedAlloc(size_t size, size_t alignment, const char* file, int line, void* caller) {
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, std::max(alignment, sizeof(void*)), size) != 0)
         return nullptr;
+    return recordAlloc(ptr, size, file, line, caller);
+}
+
+void* MemoryTracker::recordAlloc(void* ptr, size_t size, const char* file, int line, void* caller) {
+    if (!ptr || inTracker || slotRetired || !enabled.load(std::memory_order_relaxed)) {
+        return ptr;
     }
+    TrackerScope scope;
     
-    uint64_t timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
-        std::chrono::system_clock::now().time_since_epoch()).count();
+    ThreadCounters& local = localCounters();
+    uint64_t count = local.count.load(std::memory_order_relaxed) + 1;
+    local.count.store(count, std::memory_order_relaxed);
+    bump(local.allocated, size);
+    int sc = sizeClass(size);
+    bump(local.classCount[sc], 1);
+    bump(local.classBytes[sc], size);
+    publish(local, static_cast<int64_t>(size));
     
     AllocationInfo info;
     info.ptr = ptr;
     info.size = size;
     info.file = file;
     info.line = line;
-    info.timestamp = timestamp;
-    info.stackTrace = getStackTrace();
+    info.caller = caller;
+    info.timestamp = 0;
     
-    {
-        std::lock_guard<std::mutex> lock(mutex);
-        allocations[ptr] = info;
+    // Reading the clock costs about as much as malloc itself, so sampled
+    // allocations pay for it along with the stack
+    uint32_t every = sampleEvery.load(std::memory_order_relaxed);
+    size_t minSize = sampleMinSize.load(std::memory_order_relaxed);
+    if ((every && count % every == 0) || (minSize && size >= minSize)) {
+        info.timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        captureStack(info.stack);
     }
     
-    totalAllocated += size;
-    currentUsage += size;
-    allocationCount++;
-    
-    if (currentUsage.load() > peakUsage.load()) {
-        peakUsage.store(currentUsage.load());
+    Shard& shard = shardFor(ptr);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (!shard.allocations.put(info))
+            shard.stacks.erase(ptr);  // address reused without a tracked free
+        if (!info.stack.empty())
+            shard.stacks[ptr] = std::move(info.stack);
     }
     
     return ptr;
 }
 
 void MemoryTracker::trackFree(void* ptr) {
-    if (!ptr || !enabled) {
+    if (!ptr || inTracker || !enabled.load(std::memory_order_relaxed)) {
         free(ptr);
         return;
     }
+    TrackerScope scope;
     
     size_t size = 0;
+    bool tracked = false;
+    Shard& shard = shardFor(ptr);
     {
-        std::lock_guard<std::mutex> lock(mutex);
-        auto it = allocations.find(ptr);
-        if (it != allocations.end()) {
-            size = it->second.size;
-            allocations.erase(it);
-        }
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        bool sampled = false;
+        tracked = shard.allocations.take(ptr, size, sampled);
+        if (sampled)
+            shard.stacks.erase(ptr);
     }
     
-    totalFreed += size;
-    currentUsage -= size;
+    if (tracked && slotRetired) {
+        retiredFreed += size;
+        retiredFrees++;
+        publishedUsage -= static_cast<int64_t>(size);
+    } else if (tracked) {
+        ThreadCounters& local = localCounters();
+        bump(local.freed, size);
+        bump(local.frees, 1);
+        publish(local, -static_cast<int64_t>(size));
+    }
     free(ptr);
 }
 
+uint64_t MemoryTracker::getTotalAllocated() {
+    return sumCounters(&ThreadCounters::allocated, retiredAllocated);
+}
+
+uint64_t MemoryTracker::getTotalFreed() {
+    return sumCounters(&ThreadCounters::freed, retiredFreed);
+}
+
+uint64_t MemoryTracker::getAllocationCount() {
+    return sumCounters(&ThreadCounters::count, retiredCount);
+}
+
+uint64_t MemoryTracker::getFreeCount() {
+    return sumCounters(&ThreadCounters::frees, retiredFrees);
+}
+
+uint64_t MemoryTracker::getCurrentUsage() {
+    uint64_t allocated = getTotalAllocated();
+    uint64_t freed = getTotalFreed();
+    return allocated > freed ? allocated - freed : 0;
+}
+
+uint64_t MemoryTracker::getPeakUsage() {
+    // Unpublished bytes can only make the current usage the peak
+    return std::max(peakUsage.load(), getCurrentUsage());
+}
+
+std::vector<SizeClassStats> MemoryTracker::getSizeClassHistogram() {
+    std::vector<SizeClassStats> histogram(SizeClassCount);
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (int c = 0; c < SizeClassCount; c++) {
+        SizeClassStats& stats = histogram[c];
+        stats.maxSize = c == SizeClassCount - 1 ? SIZE_MAX : size_t(16) << c;
+        stats.allocations = retiredClassCount[c].load();
+        stats.bytes = retiredClassBytes[c].load();
+        for (ThreadCounters* counters = registry; counters; counters = counters->next) {
+            stats.allocations += counters->classCount[c].load(std::memory_order_relaxed);
+            stats.bytes += counters->classBytes[c].load(std::memory_order_relaxed);
+        }
+    }
+    return histogram;
+}
+
+size_t MemoryTracker::getActiveAllocations() {
+    TrackerScope scope;
+    size_t active = 0;
+    for (size_t i = 0; i < ShardCount; i++) {
+        Shard& shard = shardTable()[i];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        active += shard.allocations.size();
+    }
+    return active;
+}
+
 double MemoryTracker::getFragmentationPercentage() {
-    if (peakUsage == 0) return 0.0;
-    return (static_cast<double>(fragmentation) / peakUsage) * 100.0;
+    uint64_t peak = getPeakUsage();
+    if (peak == 0) return 0.0;
+    return (static_cast<double>(fragmentation) / peak) * 100.0;
 }
 
 void MemoryTracker::generateReport(const std::string& filename) {
+    TrackerScope scope;
     std::ofstream file(filename);
     if (!file.is_open()) return;
     
@@ -139,34 +562,50 @@ void MemoryTracker::generateReport(const std::string& filename) {
     file << "Peak Usage: " << getPeakUsage() << " bytes\n";
     file << "Allocation Count: " << getAllocationCount() << "\n";
     file << "Fragmentation: " << getFragmentationPercentage() << "%\n";
-    file << "Active Allocations: " << allocations.size() << "\n\n";
+    file << "Active Allocations: " << getActiveAllocations() << "\n\n";
     
-    if (!allocations.empty()) {
-        file << "=== Active Allocations ===\n";
-        for (const auto& [ptr, info] : allocations) {
-            file << "Ptr: " << ptr << " | Size: " << info.size 
-                 << " bytes | File: " << info.file << ":" << info.line << "\n";
+    file << "=== Allocations by Size ===\n";
+    size_t lower = 0;
+    for (const SizeClassStats& stats : getSizeClassHistogram()) {
+        if (stats.allocations > 0) {
+            file << lower << "-";
+            if (stats.maxSize == SIZE_MAX) file << "max"; else file << stats.maxSize;
+            file << " bytes | Count: " << stats.allocations
+                 << " | Bytes: " << stats.bytes << "\n";
         }
+        lower = stats.maxSize + 1;
     }
+    file << "\n";
+    
+    bool header = false;
+    forEachAllocation([&](const AllocationInfo& info) {
+        if (!header) {
+            file << "=== Active Allocations ===\n";
+            header = true;
+        }
+        file << "Ptr: " << info.ptr << " | Size: " << info.size 
+             << " bytes | Site: " << formatSite(info) << "\n";
+    });
     
     file.close();
 }
 
 void MemoryTracker::generateLeakReport(const std::string& filename) {
+    TrackerScope scope;
     std::ofstream file(filename);
     if (!file.is_open()) return;
     
     file << "=== Memory Leak Report ===\n";
-    file << "Total Leaks: " << allocations.size() << "\n";
-    file << "Total Leaked Memory: " << currentUsage << " bytes\n\n";
+    file << "Total Leaks: " << getActiveAllocations() << "\n";
+    file << "Total Leaked Memory: " << getCurrentUsage() << " bytes\n\n";
     
-    for (const auto& [ptr, info] : allocations) {
-        file << "Leak at " << info.file << ":" << info.line << "\n";
+    forEachAllocation([&](const AllocationInfo& info) {
+        file << "Leak at " << formatSite(info) << "\n";
         file << "Size: " << info.size << " bytes\n";
-        file << "Address: " << ptr << "\n";
-        file << "Stack Trace:\n" << info.stackTrace << "\n";
+        file << "Address: " << info.ptr << "\n";
+        file << "Stack Trace:\n" << formatStack(info.stack) << "\n";
         file << "-------------------\n";
-    }
+    });
     
     file.close();
 }
@@ -174,7 +613,7 @@ void MemoryTracker::generateLeakReport(const std::string& filename) {
 void MemoryTracker::logAllocation(void* ptr, size_t size, const char* file, int line) {
     if (!enabled) return;
     
-    std::lock_guard<std::mutex> lock(mutex);
+    std::lock_guard<std::mutex> lock(logMutex);
     std::cout << "[ALLOC] " << ptr << " | " << size << " bytes | " 
               << file << ":" << line << "\n";
 }
@@ -182,7 +621,7 @@ void MemoryTracker::logAllocation(void* ptr, size_t size, const char* file, int
 void MemoryTracker::logDeallocation(void* ptr) {
     if (!enabled) return;
     
-    std::lock_guard<std::mutex> lock(mutex);
+    std::lock_guard<std::mutex> lock(logMutex);
     std::cout << "[FREE] " << ptr << "\n";
 }
 
@@ -195,31 +634,26 @@ void MemoryTracker::free_hook(void* ptr) {
 }
 
 void MemoryTracker::analyzeFragmentation() {
-    std::lock_guard<std::mutex> lock(mutex);
+    TrackerScope scope;
     
-    if (allocations.empty()) {
+    // Snapshot (address, size) of the live allocations, sorted by address
+    std::vector<std::pair<uintptr_t, size_t>> sorted;
+    forEachAllocation([&](const AllocationInfo& info) {
+        sorted.emplace_back(reinterpret_cast<uintptr_t>(info.ptr), info.size);
+    });
+    
+    if (sorted.empty()) {
         fragmentation = 0;
         return;
     }
     
-    // Sort allocations by address
-    std::vector<AllocationInfo> sorted;
-    sorted.reserve(allocations.size());
-    
-    for (const auto& [ptr, info] : allocations) {
-        sorted.push_back(info);
-    }
-    
-    std::sort(sorted.begin(), sorted.end(), 
-              [](const AllocationInfo& a, const AllocationInfo& b) {
-                  return reinterpret_cast<uintptr_t>(a.ptr) < reinterpret_cast<uintptr_t>(b.ptr);
-              });
+    std::sort(sorted.begin(), sorted.end());
     
     // Calculate fragmentation (gaps between allocations)
     uint64_t totalGap = 0;
     for (size_t i = 1; i < sorted.size(); i++) {
-        uintptr_t prevEnd = reinterpret_cast<uintptr_t>(sorted[i-1].ptr) + sorted[i-1].size;
-        uintptr_t currStart = reinterpret_cast<uintptr_t>(sorted[i].ptr);
+        uintptr_t prevEnd = sorted[i-1].first + sorted[i-1].second;
+        uintptr_t currStart = sorted[i].first;
         if (currStart > prevEnd) {
             totalGap += (currStart - prevEnd);
         }
@@ -228,6 +662,221 @@ void MemoryTracker::analyzeFragmentation() {
     fragmentation = totalGap;
 }
 
+// Timeline: a sampler thread closes one bucket every bucketMicros and
+// pushes it into a ring that keeps the most recent buckets
+namespace {
+    struct TimelineSample {
+        uint64_t micros;  // end of the bucket, since startTimeline()
+        uint64_t span;    // bucket length in microseconds
+        uint64_t current;
+        uint64_t peak;
+        uint64_t allocs;
+        uint64_t frees;
+        uint64_t allocBytes;
+        uint64_t freeBytes;
+    };
+    
+    struct PhaseMark {
+        uint64_t micros;
+        std::string name;
+    };
+    
+    // Fixed-capacity ring that overwrites its oldest entry when full
+    template<typename T>
+    struct Ring {
+        std::vector<T> items;
+        size_t next = 0;
+        size_t count = 0;
+        
+        void clear(size_t capacity) {
+            items.assign(capacity, T());
+            next = 0;
+            count = 0;
+        }
+        
+        void push(T item) {
+            if (items.empty()) return;
+            items[next] = std::move(item);
+            next = (next + 1) % items.size();
+            count = std::min(count + 1, items.size());
+        }
+        
+        // Oldest first
+        const T& operator[](size_t i) const {
+            return items[(next + items.size() - count + i) % items.size()];
+        }
+    };
+    
+    struct Timeline {
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::thread sampler;
+        bool running = false;
+        uint32_t bucketMicros = 1000;
+        std::chrono::steady_clock::time_point origin;
+        Ring<TimelineSample> samples;
+        Ring<PhaseMark> marks;
+        uint64_t lastMicros = 0;
+        uint64_t lastAllocs = 0;
+        uint64_t lastFrees = 0;
+        uint64_t lastAllocBytes = 0;
+        uint64_t lastFreeBytes = 0;
+    };
+    
+    Timeline& timeline() {
+        static Timeline* instance = new Timeline();
+        return *instance;
+    }
+    
+    uint64_t elapsedMicros(const Timeline& t) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - t.origin).count();
+    }
+    
+    // Counters drop back to zero when reset() runs between buckets
+    uint64_t sinceLast(uint64_t now, uint64_t& last) {
+        uint64_t delta = now >= last ? now - last : now;
+        last = now;
+        return delta;
+    }
+    
+    // Closes the current bucket; called with t.mutex held
+    void closeBucket(Timeline& t) {
+        TimelineSample sample;
+        sample.micros = elapsedMicros(t);
+        sample.span = sample.micros - t.lastMicros;
+        t.lastMicros = sample.micros;
+        sample.current = MemoryTracker::getCurrentUsage();
+        int64_t published = std::max<int64_t>(publishedUsage.load(), 0);
+        sample.peak = std::max<uint64_t>(windowPeak.exchange(published), sample.current);
+        sample.allocs = sinceLast(MemoryTracker::getAllocationCount(), t.lastAllocs);
+        sample.frees = sinceLast(MemoryTracker::getFreeCount(), t.lastFrees);
+        sample.allocBytes = sinceLast(MemoryTracker::getTotalAllocated(), t.lastAllocBytes);
+        sample.freeBytes = sinceLast(MemoryTracker::getTotalFreed(), t.lastFreeBytes);
+        t.samples.push(sample);
+    }
+    
+    double perSecond(uint64_t amount, uint64_t micros) {
+        return micros ? amount * 1e6 / micros : 0.0;
+    }
+    
+    std::string jsonEscape(const std::string& text) {
+        std::string escaped;
+        for (char c : text) {
+            if (c == '"' || c == '\\') escaped += '\\';
+            if (static_cast<unsigned char>(c) >= 0x20) escaped += c;
+        }
+        return escaped;
+    }
+}
+
+void MemoryTracker::startTimeline(uint32_t bucketMicros, size_t capacity) {
+    stopTimeline();
+    TrackerScope scope;
+    Timeline& t = timeline();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    t.bucketMicros = std::max<uint32_t>(bucketMicros, 1);
+    t.samples.clear(capacity);
+    t.marks.clear(capacity);
+    t.origin = std::chrono::steady_clock::now();
+    t.lastMicros = 0;
+    t.lastAllocs = getAllocationCount();
+    t.lastFrees = getFreeCount();
+    t.lastAllocBytes = getTotalAllocated();
+    t.lastFreeBytes = getTotalFreed();
+    windowPeak = getCurrentUsage();
+    t.running = true;
+    t.sampler = std::thread([&t] {
+        TrackerScope samplerScope;
+        std::unique_lock<std::mutex> lock(t.mutex);
+        auto deadline = std::chrono::steady_clock::now();
+        while (t.running) {
+            deadline += std::chrono::microseconds(t.bucketMicros);
+            t.wake.wait_until(lock, deadline, [&t] { return !t.running; });
+            closeBucket(t);
+        }
+    });
+}
+
+void MemoryTracker::stopTimeline() {
+    Timeline& t = timeline();
+    {
+        std::lock_guard<std::mutex> lock(t.mutex);
+        if (!t.running) return;
+        t.running = false;
+    }
+    t.wake.notify_all();
+    t.sampler.join();
+}
+
+void MemoryTracker::markPhase(const std::string& name) {
+    TrackerScope scope;
+    Timeline& t = timeline();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    if (t.running)
+        t.marks.push(PhaseMark{elapsedMicros(t), name});
+}
+
+void MemoryTracker::exportTimelineCSV(const std::string& filename) {
+    TrackerScope scope;
+    std::ofstream file(filename);
+    if (!file.is_open()) return;
+    
+    Timeline& t = timeline();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    file << "Time(seconds),CurrentUsage,PeakUsage,Allocs/s,Frees/s,AllocatedBytes/s,FreedBytes/s,Phases\n";
+    size_t mark = 0;
+    for (size_t i = 0; i < t.samples.count; i++) {
+        const TimelineSample& sample = t.samples[i];
+        file << sample.micros / 1e6 << "," << sample.current << "," << sample.peak << ","
+             << perSecond(sample.allocs, sample.span) << "," << perSecond(sample.frees, sample.span) << ","
+             << perSecond(sample.allocBytes, sample.span) << "," << perSecond(sample.freeBytes, sample.span) << ",";
+        // Phases that started inside this bucket, ';'-separated
+        for (bool first = true; mark < t.marks.count && t.marks[mark].micros <= sample.micros; mark++) {
+            if (t.marks[mark].micros + sample.span <= sample.micros) continue;
+            file << (first ? "" : ";") << t.marks[mark].name;
+            first = false;
+        }
+        file << "\n";
+    }
+    file.close();
+}
+
+void MemoryTracker::exportChromeTrace(const std::string& filename) {
+    TrackerScope scope;
+    std::ofstream file(filename);
+    if (!file.is_open()) return;
+    
+    Timeline& t = timeline();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    // Counter tracks for usage and rates, instant events for the phases;
+    // load in chrome://tracing or ui.perfetto.dev
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    auto event = [&](const std::string& body) {
+        file << (first ? "" : ",\n") << "{" << body << ",\"pid\":1,\"tid\":1}";
+        first = false;
+    };
+    for (size_t i = 0; i < t.samples.count; i++) {
+        const TimelineSample& sample = t.samples[i];
+        std::string ts = ",\"ph\":\"C\",\"ts\":" + std::to_string(sample.micros);
+        event("\"name\":\"memory\"" + ts + ",\"args\":{\"current\":" + std::to_string(sample.current) +
+              ",\"peak\":" + std::to_string(sample.peak) + "}");
+        event("\"name\":\"allocations/s\"" + ts + ",\"args\":{\"allocs\":" +
+              std::to_string(perSecond(sample.allocs, sample.span)) + ",\"frees\":" +
+              std::to_string(perSecond(sample.frees, sample.span)) + "}");
+        event("\"name\":\"bytes/s\"" + ts + ",\"args\":{\"allocated\":" +
+              std::to_string(perSecond(sample.allocBytes, sample.span)) + ",\"freed\":" +
+              std::to_string(perSecond(sample.freeBytes, sample.span)) + "}");
+    }
+    for (size_t i = 0; i < t.marks.count; i++) {
+        event("\"name\":\"" + jsonEscape(t.marks[i].name) + "\",\"ph\":\"i\",\"s\":\"g\",\"ts\":" +
+              std::to_string(t.marks[i].micros));
+    }
+    file << "\n]}\n";
+    file.close();
+}
+
 // Operator new overloads
 void* operator new(size_t size, const char* file, int line) {
     return MemoryTracker::trackAlloc(size, file, line);
@@ -244,12 +893,3 @@ void operator delete(void* ptr, const char* file, int line) noexcept {
 void operator delete[](void* ptr, const char* file, int line) noexcept {
     MemoryTracker::trackFree(ptr);
 }
-
-// Regular delete operators
-void operator delete(void* ptr) noexcept {
-    MemoryTracker::trackFree(ptr);
-}
-
-void operator delete[](void* ptr) noexcept {
-    MemoryTracker::trackFree(ptr);
-}
\ No newline at end of file
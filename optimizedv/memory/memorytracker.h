@@ -3,10 +3,8 @@
 
 #include <cstddef>
 #include <cstdint>
-#include <unordered_map>
 #include <vector>
 #include <string>
-#include <mutex>
 #include <atomic>
 #include <fstream>
 
@@ -15,39 +13,66 @@ struct AllocationInfo {
     size_t size;
     const char* file;
     int line;
-    uint64_t timestamp;
-    std::string stackTrace;
+    void* caller;              // operator new's return address; null when file:line is the site
+    uint64_t timestamp;        // microseconds; 0 unless sampled
+    std::vector<void*> stack;  // raw return addresses; empty unless sampled
 };
 
+// Allocations of size in (previous maxSize, maxSize]
+struct SizeClassStats {
+    size_t maxSize;
+    uint64_t allocations;
+    uint64_t bytes;
+};
+
+// Allocation tracker built to stay cheap on multi-threaded runs: byte and
+// call counters live in per-thread slots summed on demand, live allocations
+// sit in a table sharded by address, and stack traces are only captured
+// for a sample of allocations and symbolized when a report is written.
 class MemoryTracker {
 private:
-    static std::unordered_map<void*, AllocationInfo> allocations;
-    static std::mutex mutex;
-    static std::atomic<uint64_t> totalAllocated;
-    static std::atomic<uint64_t> totalFreed;
-    static std::atomic<uint64_t> peakUsage;
-    static std::atomic<uint64_t> currentUsage;
-    static std::atomic<uint64_t> allocationCount;
+    static std::atomic<bool> enabled;
+    static std::atomic<uint32_t> sampleEvery;
+    static std::atomic<size_t> sampleMinSize;
     static std::atomic<uint64_t> fragmentation;
-    static bool enabled;
     
-    static std::string getStackTrace(int maxDepth = 10);
+    static void* recordAlloc(void* ptr, size_t size, const char* file, int line, void* caller);
+    static void captureStack(std::vector<void*>& stack, int maxDepth = 16);
+    static std::string formatStack(const std::vector<void*>& stack);
+    static std::string formatSite(const AllocationInfo& info);
     
 public:
+    // Power-of-two size classes: <=16, <=32, ... <=512 MiB, then larger
+    static const int SizeClassCount = 27;
+    static int sizeClass(size_t size);
+    
     static void enable();
     static void disable();
     static void reset();
     
-    static void* trackAlloc(size_t size, const char* file = __builtin_FILE(), int line = __builtin_LINE());
+    // Capture a stack for every Nth allocation of a thread and for every
+    // allocation of at least minSize bytes; 0 turns a trigger off
+    static void setStackSampling(uint32_t everyN, size_t minSize);
+    
+    // caller is set by the global operator new replacements, which have no
+    // file:line of their own; reports name the function it returns into
+    static void* trackAlloc(size_t size, const char* file = __builtin_FILE(), int line = __builtin_LINE(),
+                            void* caller = nullptr);
+    static void* trackAlignedAlloc(size_t size, size_t alignment, const char* file, int line,
+                                   void* caller = nullptr);
     static void trackFree(void* ptr);
     
     // Statistics
-    static uint64_t getTotalAllocated() { return totalAllocated.load(); }
-    static uint64_t getTotalFreed() { return totalFreed.load(); }
-    static uint64_t getPeakUsage() { return peakUsage.load(); }
-    static uint64_t getCurrentUsage() { return currentUsage.load(); }
-    static uint64_t getAllocationCount() { return allocationCount.load(); }
+    static uint64_t getTotalAllocated();
+    static uint64_t getTotalFreed();
+    // Exact to within 64 KiB per thread still running tracked code
+    static uint64_t getPeakUsage();
+    static uint64_t getCurrentUsage();
+    static uint64_t getAllocationCount();
+    static uint64_t getFreeCount();
+    static size_t getActiveAllocations();
     static double getFragmentationPercentage();
+    static std::vector<SizeClassStats> getSizeClassHistogram();
     
     // Reports
     static void generateReport(const std::string& filename = "memory_report.txt");
@@ -61,6 +86,15 @@ public:
     
     // Memory fragmentation analysis
     static void analyzeFragmentation();
+    
+    // Timeline: a background thread samples usage, the peak within each
+    // bucket and allocation rates every bucketMicros, keeping the last
+    // `capacity` buckets. Phase marks label the search phases in exports.
+    static void startTimeline(uint32_t bucketMicros = 1000, size_t capacity = 65536);
+    static void stopTimeline();
+    static void markPhase(const std::string& name);
+    static void exportTimelineCSV(const std::string& filename = "memory_timeline.csv");
+    static void exportChromeTrace(const std::string& filename = "memory_timeline.json");
 };
 
 // Macro for easy tracking
@@ -80,8 +114,8 @@ void* operator new[](size_t size, const char* file, int line);
 void operator delete(void* ptr, const char* file, int line) noexcept;
 void operator delete[](void* ptr, const char* file, int line) noexcept;
 
-// Ensure normal delete still works
-void operator delete(void* ptr) noexcept;
-void operator delete[](void* ptr) noexcept;
+// globalnew.cpp replaces every global operator new and delete (plain,
+// array, sized, aligned and nothrow) with tracked versions; only
+// TRACK_MEMORY builds link it
 
 #endif // MEMORY_TRACKER_H
\ No newline at end of file
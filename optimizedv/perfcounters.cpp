@@ -0,0 +1,112 @@
+#include "perfcounters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+PerfCounters::PerfCounters() {
+    for (int& fd : fds)
+        fd = -1;
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+    for (int fd : fds) {
+        if (fd != -1)
+            close(fd);
+    }
+#endif
+}
+
+const char* PerfCounters::name(PerfEvent event) {
+    switch (event) {
+        case PerfCycles: return "Cycles";
+        case PerfInstructions: return "Instructions";
+        case PerfL1DMisses: return "L1DMisses";
+        case PerfLLCMisses: return "LLCMisses";
+        case PerfBranchMisses: return "BranchMisses";
+        case PerfDTLBMisses: return "DTLBMisses";
+        default: return "unknown";
+    }
+}
+
+#ifdef __linux__
+namespace {
+    // Each event gets its own counter rather than a group: inherited
+    // counters (needed to see worker threads) cannot be read as a group
+    int openEvent(uint32_t type, uint64_t config) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+    
+    const uint64_t L1DReadMiss = PERF_COUNT_HW_CACHE_L1D |
+                                 (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                 (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    const uint64_t DTLBReadMiss = PERF_COUNT_HW_CACHE_DTLB |
+                                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+bool PerfCounters::open() {
+    fds[PerfCycles] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    fds[PerfInstructions] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    fds[PerfL1DMisses] = openEvent(PERF_TYPE_HW_CACHE, L1DReadMiss);
+    fds[PerfLLCMisses] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    fds[PerfBranchMisses] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    fds[PerfDTLBMisses] = openEvent(PERF_TYPE_HW_CACHE, DTLBReadMiss);
+    return available();
+}
+
+void PerfCounters::start() {
+    for (int fd : fds) {
+        if (fd != -1) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+PerfSample PerfCounters::stop() {
+    PerfSample sample;
+    for (int fd : fds) {
+        if (fd != -1)
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+    for (int event = 0; event < PerfEventCount; ++event) {
+        // value, time enabled, time running
+        uint64_t data[3];
+        if (fds[event] == -1 || read(fds[event], data, sizeof(data)) != sizeof(data) || data[2] == 0)
+            continue;
+        sample.valid[event] = true;
+        sample.value[event] = data[2] < data[1]
+            ? static_cast<uint64_t>(static_cast<double>(data[0]) * data[1] / data[2])
+            : data[0];
+    }
+    return sample;
+}
+#else
+bool PerfCounters::open() { return false; }
+void PerfCounters::start() {}
+PerfSample PerfCounters::stop() { return PerfSample(); }
+#endif
+
+bool PerfCounters::available() const {
+    for (int fd : fds) {
+        if (fd != -1)
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,49 @@
+#ifndef NQUEENS_PERF_COUNTERS_H
+#define NQUEENS_PERF_COUNTERS_H
+
+#include <cstdint>
+
+// Hardware events counted around each solve
+enum PerfEvent {
+    PerfCycles,
+    PerfInstructions,
+    PerfL1DMisses,      // L1 data cache read misses
+    PerfLLCMisses,      // last-level cache misses
+    PerfBranchMisses,
+    PerfDTLBMisses,     // data TLB read misses
+    PerfEventCount
+};
+
+struct PerfSample {
+    bool valid[PerfEventCount] = {};
+    uint64_t value[PerfEventCount] = {};
+};
+
+// Per-process counters through Linux perf_event_open. Threads spawned while
+// counting (the parallel DFS workers) are included. Events the kernel or CPU
+// refuses (no PMU in a VM, perf_event_paranoid too strict, not Linux) are
+// left out, and stop() reports them as invalid.
+class PerfCounters {
+private:
+    int fds[PerfEventCount];
+    
+public:
+    PerfCounters();
+    ~PerfCounters();
+    
+    // Opens every event it can; false when none could be opened
+    bool open();
+    bool available() const;
+    
+    void start();
+    // Values are scaled up when the kernel multiplexed the counters
+    PerfSample stop();
+    
+    static const char* name(PerfEvent event);
+    
+    // Disable copying
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+};
+
+#endif // NQUEENS_PERF_COUNTERS_H
@@ -0,0 +1,38 @@
+#ifndef NQUEENS_SEARCH_STATS_H
+#define NQUEENS_SEARCH_STATS_H
+
+#include <cstdint>
+
+// Algorithmic work done by one solve, to compare solvers independently of
+// constant-factor speed. Updates through STAT_ADD compile to nothing unless
+// TRACK_STATS is defined; counters a solver keeps anyway (CSP nodes,
+// min-conflicts restarts and moves) are filled in either way.
+struct SearchStats {
+    uint64_t nodes = 0;       // queens placed (DFS, CSP), candidate squares scored (min-conflicts)
+    uint64_t backtracks = 0;  // rows left with nothing to try (DFS), exhausted decisions (CSP)
+    uint64_t pruned = 0;      // domain values removed by propagation (CSP)
+    uint64_t revisions = 0;   // arcs revised by AC3 (CSP)
+    uint64_t restarts = 0;    // fresh boards after the first (min-conflicts)
+    uint64_t moves = 0;       // queens moved (min-conflicts)
+    uint64_t sideways = 0;    // moves that left the conflict count unchanged (min-conflicts)
+    
+    void merge(const SearchStats& other) {
+        nodes += other.nodes;
+        backtracks += other.backtracks;
+        pruned += other.pruned;
+        revisions += other.revisions;
+        restarts += other.restarts;
+        moves += other.moves;
+        sideways += other.sideways;
+    }
+};
+
+#ifdef TRACK_STATS
+    const bool SearchStatsEnabled = true;
+    #define STAT_ADD(stats, field, amount) ((stats).field += (amount))
+#else
+    const bool SearchStatsEnabled = false;
+    #define STAT_ADD(stats, field, amount) ((void)0)
+#endif
+
+#endif // NQUEENS_SEARCH_STATS_H
@@ -0,0 +1,116 @@
+// Checks the LCV order built from the support counters against a brute-force
+// count of the values each candidate would remove, over random partial
+// assignments reached by assigning, propagating and backtracking.
+#include "csp_trials.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    // Values of the other unassigned rows that putting a queen on (row, col)
+    // would remove: the squares it attacks in each row that are still legal
+    int brute_force_count(const CSPState& state, int row, int col) {
+        int count = 0;
+        for (int r = 0; r < state.n; ++r) {
+            if (r == row || state.assignment[r] != -1)
+                continue;
+            int k = abs(r - row);
+            for (int c : { col - k, col, col + k }) {
+                if (c >= 0 && c < state.n && state.domains.has(r, c))
+                    count++;
+            }
+        }
+        return count;
+    }
+    
+    // sorted_lcv() must list every value of row once, by brute-force count,
+    // then centre distance, then column
+    bool check_order(CSPState& state, int row) {
+        vector<pair<int, int>> expected;
+        state.domains.for_each(row, [&](int col) {
+            expected.push_back({ brute_force_count(state, row, col), col });
+        });
+        int n = state.n;
+        stable_sort(expected.begin(), expected.end(), [n](const pair<int, int>& a, const pair<int, int>& b) {
+            if (a.first != b.first)
+                return a.first < b.first;
+            return centre_distance(n, a.second) < centre_distance(n, b.second);
+        });
+        
+        state.values.clear();
+        sorted_lcv(state, row);
+        bool ok = state.values.size() == expected.size();
+        for (size_t i = 0; ok && i < expected.size(); ++i)
+            ok = state.values[i] == expected[i].second;
+        if (!ok) {
+            fprintf(stderr, "N = %d, row %d: LCV order differs from the brute-force counts\n", n, row);
+            fprintf(stderr, "  got     ");
+            for (int col : state.values)
+                fprintf(stderr, " %d", col);
+            fprintf(stderr, "\n  expected");
+            for (auto& [count, col] : expected)
+                fprintf(stderr, " %d(%d)", col, count);
+            fprintf(stderr, "\n");
+        }
+        state.values.clear();
+        return ok;
+    }
+    
+    // Assigns random values to random rows, backtracking on wipeouts and at
+    // random, and checks the order of a few unassigned rows at each step
+    bool run_trial(int n, Consistency consistency, int steps) {
+        CSPState state(n, true);
+        state.consistency = consistency;
+        vector<pair<int, size_t>> decisions;  // (row, trail mark)
+        
+        for (int step = 0; step < steps; ++step) {
+            for (int i = 0; i < 4; ++i) {
+                int row = rand() % n;
+                if (state.assignment[row] == -1 && !check_order(state, row))
+                    return false;
+            }
+            
+            bool retract = !decisions.empty() && (state.assigned == n || rand() % 4 == 0);
+            if (retract) {
+                auto [row, mark] = decisions.back();
+                decisions.pop_back();
+                undo(state, mark);
+                unassign(state, row);
+                continue;
+            }
+            
+            int row = state.mrv.select();
+            if (rand() % 2) {
+                do {
+                    row = rand() % n;
+                } while (state.assignment[row] != -1);
+            }
+            if (state.domains.size(row) == 0)
+                continue;
+            vector<int> values;
+            state.domains.for_each(row, [&](int col) { values.push_back(col); });
+            int col = values[rand() % values.size()];
+            
+            size_t mark = state.trail.size();
+            assign(state, row, col);
+            decisions.push_back({ row, mark });
+            if (!forward_check(state, row, col)) {
+                decisions.pop_back();
+                undo(state, mark);
+                unassign(state, row);
+            }
+        }
+        return true;
+    }
+}
+
+int main() {
+    // Sizes on both sides of the 64-bit word boundary
+    return run_trials("LCV order", "matched the brute-force counts", { 4, 5, 8, 13, 31, 63, 64, 65, 130 }, 8,
+                      [](int n, int trial) {
+                          Consistency consistency = trial % 2 ? Consistency::AC3 : Consistency::ForwardCheck;
+                          return run_trial(n, consistency, 2 * n);
+                      });
+}
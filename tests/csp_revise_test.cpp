@@ -0,0 +1,94 @@
+// Fuzzes the word-parallel revise() against a scalar one: random domains
+// for a pair of rows on boards around the 64-bit word boundaries, so the
+// shifted masks cross words at every offset.
+#include "csp_trials.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    // Columns of row r's domain, in increasing order
+    vector<int> columns(const CSPState& state, int r) {
+        vector<int> cols;
+        state.domains.for_each(r, [&](int c) { cols.push_back(c); });
+        return cols;
+    }
+    
+    // Column c of row r2 keeps a support in row r1 when some value of r1
+    // does not attack it, i.e. is neither c nor c +- |r2 - r1|
+    vector<int> scalar_revise(const CSPState& state, int r2, int r1) {
+        int k = abs(r2 - r1);
+        vector<int> d1 = columns(state, r1);
+        vector<int> kept;
+        for (int c : columns(state, r2)) {
+            for (int c1 : d1) {
+                if (c1 != c && abs(c1 - c) != k) {
+                    kept.push_back(c);
+                    break;
+                }
+            }
+        }
+        return kept;
+    }
+    
+    // Leaves `keep` random values of row r, pruned through the solver so
+    // sizes, supports and trail stay consistent
+    void shrink(CSPState& state, int r, int keep) {
+        vector<int> cols = columns(state, r);
+        for (int i = static_cast<int>(cols.size()) - 1; i > 0; --i)
+            swap(cols[i], cols[rand() % (i + 1)]);
+        for (size_t i = keep; i < cols.size(); ++i)
+            prune(state, r, cols[i]);
+    }
+    
+    void print(const char* label, const vector<int>& cols) {
+        fprintf(stderr, "  %s", label);
+        for (int c : cols)
+            fprintf(stderr, " %d", c);
+        fprintf(stderr, "\n");
+    }
+    
+    bool run_trial(int n) {
+        CSPState state(n, true);
+        int r1 = rand() % n;
+        int r2 = rand() % (n - 1);
+        if (r2 >= r1)
+            r2++;
+        
+        // revise() only prunes when r1 is down to 3 values; larger domains
+        // check that it then leaves r2 alone. An empty r1 is left to the
+        // caller's wipeout check, so it is not drawn.
+        int sizes[] = { 1, 2, 3, 1 + rand() % n };
+        shrink(state, r1, sizes[rand() % 4]);
+        // Dense, sparse and near-empty rows for r2
+        int density = rand() % 3;
+        shrink(state, r2, density == 0 ? n : density == 1 ? n / 2 : 1 + rand() % 4);
+        
+        vector<int> d1 = columns(state, r1);
+        vector<int> d2 = columns(state, r2);
+        vector<int> expected = scalar_revise(state, r2, r1);
+        size_t mark = state.trail.size();
+        int removed = revise(state, r2, r1);
+        vector<int> got = columns(state, r2);
+        
+        bool ok = got == expected && columns(state, r1) == d1
+                  && removed == static_cast<int>(d2.size() - expected.size())
+                  && state.domains.size(r2) == static_cast<int>(got.size())
+                  && state.trail.size() - mark == static_cast<size_t>(removed);
+        if (!ok) {
+            fprintf(stderr, "N = %d, revise(r2 = %d, r1 = %d) removed %d\n", n, r2, r1, removed);
+            print("r1:      ", d1);
+            print("r2:      ", d2);
+            print("expected:", expected);
+            print("got:     ", got);
+        }
+        return ok;
+    }
+}
+
+int main() {
+    return run_trials("revise", "matched the scalar version", { 4, 5, 8, 31, 63, 64, 65, 127, 128, 129, 191, 200 },
+                      2000, [](int n, int) { return run_trial(n); });
+}
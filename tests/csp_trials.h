@@ -0,0 +1,34 @@
+#ifndef NQUEENS_CSP_TRIALS_H
+#define NQUEENS_CSP_TRIALS_H
+
+// Scaffolding of the randomized CSP tests: a fixed seed, a number of trials
+// per board size, and a summary line and exit code for main()
+
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+
+#include "csp_internal.h"
+
+// Calls trial(n, t) for t = 0 .. trials - 1 on every size, rewinding the
+// board arena after each; a trial returns false (after printing why) on a
+// mismatch. Prints "<what>: X of Y trials <passed>".
+template<typename Trial>
+int run_trials(const char* what, const char* passed, std::initializer_list<int> sizes, int trials,
+               Trial trial) {
+    srand(1);
+    int failures = 0;
+    int total = 0;
+    for (int n : sizes) {
+        for (int t = 0; t < trials; ++t) {
+            if (!trial(n, t))
+                failures++;
+            total++;
+            cspBoardArena.reset();
+        }
+    }
+    printf("%s: %d of %d trials %s\n", what, total - failures, total, passed);
+    return failures == 0 ? 0 : 1;
+}
+
+#endif // NQUEENS_CSP_TRIALS_H
@@ -0,0 +1,179 @@
+// Stress test of MemoryPool's lock-free depots. Threads allocate blocks of
+// every size class, stamp them, and free them locally or hand them to
+// another thread, so batches keep moving between thread caches and the
+// Treiber stacks; each round's threads exit and flush their caches into
+// the depots. A block handed out twice shows up as a broken stamp. A last
+// phase streams one size class between a producer and a consumer until its
+// 16-bit ABA tag has wrapped twice.
+#include "memory/memorypool.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace {
+    struct Item {
+        void* ptr;
+        size_t size;
+        uint64_t stamp;
+    };
+    
+    // Blocks sent to a thread, freed by it (or by main once it has exited)
+    struct Mailbox {
+        std::mutex mutex;
+        std::vector<Item> items;
+    };
+    
+    std::atomic<int> failures{0};
+    
+    uint64_t xorshift(uint64_t& state) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+    
+    // The stamp and its complement go in the first and last words, which
+    // every block size has
+    void stamp(const Item& item) {
+        uint64_t* words = static_cast<uint64_t*>(item.ptr);
+        words[0] = item.stamp;
+        words[item.size / 8 - 1] = ~item.stamp;
+    }
+    
+    void release(MemoryPool& pool, const Item& item) {
+        const uint64_t* words = static_cast<const uint64_t*>(item.ptr);
+        if (words[0] != item.stamp || words[item.size / 8 - 1] != ~item.stamp) {
+            if (failures++ < 10)
+                fprintf(stderr, "Block %p (%zu bytes) was overwritten while allocated\n", item.ptr, item.size);
+        }
+        pool.deallocate(item.ptr, item.size);
+    }
+    
+    void drain(MemoryPool& pool, Mailbox& mailbox) {
+        std::vector<Item> items;
+        {
+            std::lock_guard<std::mutex> lock(mailbox.mutex);
+            items.swap(mailbox.items);
+        }
+        for (const Item& item : items)
+            release(pool, item);
+    }
+    
+    // Random sizes, weighted towards the small classes; a few go past the
+    // largest class to ::operator new
+    size_t random_size(uint64_t& rng) {
+        int c = xorshift(rng) % (MemoryPool::ClassCount + 1);
+        size_t limit = MemoryPool::MinBlock << c;
+        size_t size = 16 + xorshift(rng) % limit;
+        return size & ~size_t(7);
+    }
+    
+    void worker(MemoryPool& pool, std::vector<Mailbox>& mailboxes, int id, int ops) {
+        uint64_t rng = 0x9E3779B97F4A7C15ULL * (id + 1);
+        uint64_t serial = uint64_t(id) << 40;
+        std::vector<Item> live;
+        
+        for (int op = 0; op < ops; ++op) {
+            uint64_t r = xorshift(rng);
+            if (live.size() < 16 || (live.size() < 512 && r % 2)) {
+                Item item;
+                item.size = random_size(rng);
+                item.ptr = pool.allocate(item.size, AllocInit::Uninitialized);
+                item.stamp = ++serial;
+                stamp(item);
+                live.push_back(item);
+            } else {
+                size_t i = (r >> 8) % live.size();
+                Item item = live[i];
+                live[i] = live.back();
+                live.pop_back();
+                if ((r >> 4) % 3 == 0) {
+                    Mailbox& to = mailboxes[(r >> 32) % mailboxes.size()];
+                    std::lock_guard<std::mutex> lock(to.mutex);
+                    to.items.push_back(item);
+                } else {
+                    release(pool, item);
+                }
+            }
+            if (op % 64 == 0)
+                drain(pool, mailboxes[id]);
+        }
+        
+        for (const Item& item : live)
+            release(pool, item);
+        drain(pool, mailboxes[id]);
+    }
+    
+    // Every block the producer allocates is freed by the consumer: each
+    // BatchBlocks blocks the consumer frees are pushed onto the depot, and
+    // the producer pops them back when its cache runs dry
+    void stream(MemoryPool& pool, Mailbox& channel, bool producer, size_t blocks) {
+        if (producer) {
+            std::vector<Item> outgoing;
+            for (size_t i = 0; i < blocks; ++i) {
+                Item item = { pool.allocate(16, AllocInit::Uninitialized), 16, i + 1 };
+                stamp(item);
+                outgoing.push_back(item);
+                if (outgoing.size() == 256) {
+                    std::lock_guard<std::mutex> lock(channel.mutex);
+                    channel.items.insert(channel.items.end(), outgoing.begin(), outgoing.end());
+                    outgoing.clear();
+                }
+            }
+            std::lock_guard<std::mutex> lock(channel.mutex);
+            channel.items.insert(channel.items.end(), outgoing.begin(), outgoing.end());
+        } else {
+            size_t received = 0;
+            while (received < blocks) {
+                std::vector<Item> items;
+                {
+                    std::lock_guard<std::mutex> lock(channel.mutex);
+                    items.swap(channel.items);
+                }
+                if (items.empty())
+                    std::this_thread::yield();
+                for (const Item& item : items)
+                    release(pool, item);
+                received += items.size();
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    // A scale factor for longer runs; sanitizer builds keep the default
+    int scale = argc > 1 ? atoi(argv[1]) : 1;
+    const int threads = 8;
+    const int rounds = 4;
+    
+    MemoryPool pool(64, 1024);
+    std::vector<Mailbox> mailboxes(threads);
+    for (int round = 0; round < rounds; ++round) {
+        std::vector<std::thread> workers;
+        for (int id = 0; id < threads; ++id)
+            workers.emplace_back(worker, std::ref(pool), std::ref(mailboxes), id, 20000 * scale);
+        for (std::thread& t : workers)
+            t.join();
+        // Blocks sent to a thread after its last drain
+        for (Mailbox& mailbox : mailboxes)
+            drain(pool, mailbox);
+    }
+    
+    // 2^17 pushes alone advance the tag through all 2^16 values twice
+    size_t blocks = (size_t(1) << 17) * MemoryPool::BatchBlocks * scale;
+    Mailbox channel;
+    std::thread producer(stream, std::ref(pool), std::ref(channel), true, blocks);
+    std::thread consumer(stream, std::ref(pool), std::ref(channel), false, blocks);
+    producer.join();
+    consumer.join();
+    
+    if (failures > 0) {
+        fprintf(stderr, "%d corrupted blocks\n", failures.load());
+        return 1;
+    }
+    printf("MemoryPool stress: %d threads x %d rounds and %zu streamed blocks, no block handed out twice\n",
+           threads, rounds, blocks);
+    return 0;
+}
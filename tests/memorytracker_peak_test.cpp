@@ -0,0 +1,73 @@
+// Checks the peak MemoryTracker reports once threads have exited. Threads
+// hold up to 64 KiB of allocations back before publishing them, and flush
+// the rest when they exit; the flush must add only what is really pending.
+#include "memory/memorytracker.h"
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace {
+    const int Threads = 4;
+    
+    // Allocates `bytes` in a few blocks and frees them again, keeping
+    // `kept` bytes allocated past the thread's exit
+    void worker(size_t bytes, size_t kept, std::vector<void*>& leftover) {
+        std::vector<void*> blocks;
+        for (size_t done = 0; done < bytes; done += 16)
+            blocks.push_back(MemoryTracker::trackAlloc(16));
+        for (void* block : blocks)
+            MemoryTracker::trackFree(block);
+        if (kept)
+            leftover.push_back(MemoryTracker::trackAlloc(kept));
+    }
+    
+    bool run(size_t bytes, size_t kept, uint64_t maxPeak, uint64_t expectedCurrent) {
+        MemoryTracker::reset();
+        std::vector<std::vector<void*>> leftover(Threads);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < Threads; ++t)
+            threads.emplace_back(worker, bytes, kept, std::ref(leftover[t]));
+        for (std::thread& thread : threads)
+            thread.join();
+        
+        uint64_t peak = MemoryTracker::getPeakUsage();
+        uint64_t current = MemoryTracker::getCurrentUsage();
+        bool ok = peak <= maxPeak && current == expectedCurrent && peak >= current;
+        if (!ok) {
+            fprintf(stderr, "%d threads of %zu bytes, %zu kept: peak %llu (at most %llu), current %llu (expected %llu)\n",
+                    Threads, bytes, kept, static_cast<unsigned long long>(peak),
+                    static_cast<unsigned long long>(maxPeak), static_cast<unsigned long long>(current),
+                    static_cast<unsigned long long>(expectedCurrent));
+        }
+        
+        for (std::vector<void*>& blocks : leftover) {
+            for (void* block : blocks)
+                MemoryTracker::trackFree(block);
+        }
+        if (MemoryTracker::getCurrentUsage() != 0) {
+            fprintf(stderr, "%llu bytes still counted after every block was freed\n",
+                    static_cast<unsigned long long>(MemoryTracker::getCurrentUsage()));
+            ok = false;
+        }
+        return ok;
+    }
+}
+
+int main() {
+    MemoryTracker::enable();
+    int failures = 0;
+    // Short-lived threads below the publish threshold: the peak can never
+    // exceed what all of them held at once
+    failures += !run(112, 0, Threads * 112, 0);
+    // Blocks still allocated at exit are published then, and are the peak
+    failures += !run(112, 1000, Threads * (112 + 1000), Threads * 1000);
+    // Past the threshold a thread publishes as it goes
+    failures += !run(256 * 1024, 0, Threads * 256 * 1024, 0);
+    MemoryTracker::disable();
+    
+    if (failures > 0)
+        return 1;
+    printf("MemoryTracker peak: exiting threads publish only the bytes they hold\n");
+    return 0;
+}